@@ -49,60 +49,98 @@
 #include <stdlib.h>                // for free, calloc, getenv, mkdtemp
 #include <string.h>                // for strndup, strnlen, strrchr
 #include <sys/stat.h>              // for stat, S_ISREG
-#include <unistd.h>                // for unlink, rmdir
-#include "config.h"                // for FILENAME_NCHARS, DEBUG, TMP_DIRECTORY
+#include <unistd.h>                // for close, unlink, rmdir
+#include "config.h"                // for FILENAME_NCHARS, GS_ARG_NCHARS, DEBUG, TMP_DIRECTORY
 #include "pdf2laser_cli.h"         // for pdf2laser_optparse
-#include "pdf2laser_generator.h"   // for generate_eps, generate_pdf, generate_pjl, generate_ps
+#include "pdf2laser_display.h"     // for display_sink_t, display_sink_attach, display_sink_create, display_sink_destroy, display_sink_finish, display_sink_format_arg, display_sink_handle_arg
+#include "pdf2laser_generator.h"   // for generate_pdf, generate_pdf_path, generate_pjl, generate_prologue, generate_ps, source_is_postscript
 #include "pdf2laser_printer.h"     // for printer_send
-#include "pdf2laser_util.h"        // for pdf2laser_format_string
+#include "pdf2laser_util.h"        // for pdf2laser_fd_path, pdf2laser_format_string, pdf2laser_memfd_create
 #include "type_preset_file.h"      // for preset_file_t, preset_file_create, preset_file_destroy
-#include "type_print_job.h"        // for print_job_t, print_job_create, print_job_destroy, print_job_to_string
+#include "type_print_job.h"        // for print_job_t, print_job_create, print_job_destroy, print_job_has_raster, print_job_has_vector, print_job_to_string
 #include "type_raster.h"           // for raster_t
+#include "type_vector_parser.h"    // for vector_parser_t, vector_parser_create, vector_parser_destroy, vector_parser_feed, vector_parser_finish
 
-FILE *fh_vector;
-static int GSDLLCALL gsdll_stdout(__attribute__ ((unused)) void *minst, const char *str, int len)
+static int GSDLLCALL gsdll_stdout(void *caller_handle, const char *str, int len)
 {
-	size_t rc = fwrite(str, 1, len, fh_vector);
-	fflush(fh_vector);
-	return rc;
+	// Nothing is traced for raster only jobs
+	if (caller_handle != NULL)
+		vector_parser_feed(caller_handle, str, len);
+
+	return len;
 }
 
 /**
- * Execute ghostscript feeding it an ecapsulated postscript file which is then
- * converted into a bitmap image. As a byproduct output of the ghostscript
- * process is redirected to a .vector file which will contain instructions on
- * how to perform a vector cut of lines within the postscript.
+ * Execute ghostscript feeding it a postscript file which is then rendered
+ * through the display device, the raster section of the job is encoded from
+ * memory while ghostscript renders. The prologue is run ahead of the file in
+ * the same session, so the postscript never has to be rewritten. As a
+ * byproduct the stroke hook prints the vectors of the page to stdout, which
+ * are parsed into the vector lists of the print job as they arrive.
  *
- * @param filename_bitmap the filename to use for the resulting bitmap file.
- * @param filename_eps the filename to read in encapsulated postscript from.
- * @param filename_vector the filename that will contain the vector
- * information.
- * @param bmp_mode a string which is one of bmp16m, bmpgray, or bmpmono.
- * @param resolution the encapsulated postscript resolution.
+ * @param print_job the print job providing the raster mode and resolution.
+ * @param target_ps the filename to read in postscript from.
+ * @param prologue the postscript prelude built by generate_prologue.
+ * @param target_raster the filename that will contain the encoded raster
+ * section.
  *
- * @return Return true if the execution of ghostscript succeeds, false
- * otherwise.
+ * @return Return 0 if the execution of ghostscript succeeds, -1 if the
+ * raster output could not be set up, the ghostscript error code otherwise.
  */
-static int execute_ghostscript(print_job_t *print_job, const char *const target_eps, const char *const target_bmp, const char *const target_vector) //, const char *const raster_string)
+static int execute_ghostscript(print_job_t *print_job, const char *const target_ps, const char *const prologue, const char *const target_raster)
 {
-	int gs_argc = 8;
-	char *gs_argv[8];
+	FILE *fh_raster = NULL;
+	display_sink_t *display_sink = NULL;
+	vector_parser_t *vector_parser = NULL;
+
+	int gs_argc = 12;
+	char *gs_argv[12];
 
 	gs_argv[0] = "gs";
 	gs_argv[1] = "-q";
 	gs_argv[2] = "-dBATCH";
 	gs_argv[3] = "-dNOPAUSE";
 	gs_argv[4] = pdf2laser_format_string("-r%d", print_job->raster->resolution);
-	gs_argv[5] = pdf2laser_format_string("-sDEVICE=%s", raster_mode_to_device_string(print_job->raster->mode));
-	gs_argv[6] = pdf2laser_format_string("-sOutputFile=%s", target_bmp);
-	gs_argv[7] = strndup(target_eps, FILENAME_NCHARS);
 
-	fh_vector = fopen(target_vector, "w");
+	if (print_job_has_raster(print_job)) {
+		fh_raster = fopen(target_raster, "w");
+		if (fh_raster == NULL) {
+			perror(target_raster);
+			free(gs_argv[4]);
+			return -1;
+		}
+
+		display_sink = display_sink_create(print_job, fh_raster);
+		if (display_sink == NULL) {
+			perror("Failed to create display sink");
+			fclose(fh_raster);
+			free(gs_argv[4]);
+			return -1;
+		}
+
+		gs_argv[5] = strndup("-sDEVICE=display", GS_ARG_NCHARS);
+		gs_argv[6] = display_sink_format_arg(display_sink);
+		gs_argv[7] = display_sink_handle_arg(display_sink);
+	}
+	else {
+		// Vectors only, nothing needs to be painted
+		gs_argv[5] = strndup("-sDEVICE=nullpage", GS_ARG_NCHARS);
+		gs_argv[6] = strndup("-dNOINTERPOLATE", GS_ARG_NCHARS);
+		gs_argv[7] = strndup("-dNOTRANSPARENCY", GS_ARG_NCHARS);
+	}
+
+	gs_argv[8] = "-c";
+	gs_argv[9] = (char *)prologue;
+	gs_argv[10] = "-f";
+	gs_argv[11] = strndup(target_ps, FILENAME_NCHARS);
+
+	if (print_job_has_vector(print_job))
+		vector_parser = vector_parser_create(print_job);
 
 	int32_t rc;
 
 	void *minst = NULL;
-	rc = gsapi_new_instance(&minst, NULL);
+	rc = gsapi_new_instance(&minst, vector_parser);
 
 	if (rc < 0)
 		goto terminate_execute_ghostscript;
@@ -110,8 +148,11 @@ static int execute_ghostscript(print_job_t *print_job, const char *const target_
 	rc = gsapi_set_arg_encoding(minst, GS_ARG_ENCODING_UTF8);
 	if (rc == 0) {
 		gsapi_set_stdio(minst, NULL, gsdll_stdout, NULL);
-		rc = gsapi_init_with_args(minst, gs_argc, gs_argv);
+		if (display_sink != NULL)
+			rc = display_sink_attach(display_sink, minst);
 	}
+	if (rc == 0)
+		rc = gsapi_init_with_args(minst, gs_argc, gs_argv);
 
 	int32_t rc2 = gsapi_exit(minst);
 	if ((rc == 0) || (rc2 == gs_error_Quit))
@@ -119,13 +160,25 @@ static int execute_ghostscript(print_job_t *print_job, const char *const target_
 
 	gsapi_delete_instance(minst);
 
+	if (rc == 0 && display_sink != NULL)
+		rc = display_sink_finish(display_sink);
+
+	if (vector_parser != NULL)
+		vector_parser_finish(vector_parser);
+
  terminate_execute_ghostscript:
-	fclose(fh_vector);
+	vector_parser_destroy(vector_parser);
+
+	if (display_sink != NULL) {
+		display_sink_destroy(display_sink);
+		fclose(fh_raster);
+	}
 
 	free(gs_argv[4]);
 	free(gs_argv[5]);
 	free(gs_argv[6]);
 	free(gs_argv[7]);
+	free(gs_argv[11]);
 
 	return rc;
 }
@@ -217,6 +270,58 @@ static int pdf2laser_load_presets(preset_file_t ***preset_files, size_t *preset_
 }
 
 
+/**
+ * An intermediate file passed from one stage of the job to the next. The path
+ * is what gets handed to ghostscript and fopen; for in memory jobs it points
+ * at an anonymous file through /dev/fd so nothing is written to disk.
+ */
+struct target {
+	char *path;
+	int fd;
+};
+
+static struct target *target_create(print_job_t *print_job, const char *target_base, const char *extension)
+{
+	struct target *target = calloc(1, sizeof(struct target));
+	target->fd = -1;
+
+	if (print_job->in_memory) {
+		char *name = pdf2laser_format_string("%s.%s", target_base, extension);
+		target->fd = pdf2laser_memfd_create(name);
+		free(name);
+
+		if (target->fd < 0) {
+			free(target);
+			return NULL;
+		}
+
+		target->path = pdf2laser_fd_path(target->fd);
+	}
+	else {
+		target->path = pdf2laser_format_string("%s.%s", target_base, extension);
+	}
+
+	return target;
+}
+
+static int target_destroy(print_job_t *print_job, struct target *target)
+{
+	int rc = 0;
+
+	if (target->fd >= 0) {
+		close(target->fd);
+	}
+	else if (!print_job->debug && unlink(target->path)) {
+		perror(target->path);
+		rc = -1;
+	}
+
+	free(target->path);
+	free(target);
+
+	return rc;
+}
+
 /**
  * Main entry point for the program.
  *
@@ -228,14 +333,6 @@ static int pdf2laser_load_presets(preset_file_t ***preset_files, size_t *preset_
  */
 int main(int argc, char *argv[])
 {
-	// Create temp working directory
-	char *tmpdir_template = pdf2laser_format_string("%s/%s.XXXXXX", TMP_DIRECTORY, basename(argv[0]));
-	char *tmpdir_name = mkdtemp(tmpdir_template);
-	if (tmpdir_name == NULL) {
-		perror("mkdtemp failed");
-		return false;
-	}
-
 	// Load preset files
 	preset_file_t **preset_files;
 	size_t preset_files_count;
@@ -245,6 +342,17 @@ int main(int argc, char *argv[])
 	print_job_t *print_job = print_job_create();
 	pdf2laser_optparse(print_job, preset_files, preset_files_count, argc, argv);
 
+	// Create temp working directory, in memory jobs never touch it
+	char *tmpdir_name = NULL;
+	if (!print_job->in_memory) {
+		char *tmpdir_template = pdf2laser_format_string("%s/%s.XXXXXX", TMP_DIRECTORY, basename(argv[0]));
+		tmpdir_name = mkdtemp(tmpdir_template);
+		if (tmpdir_name == NULL) {
+			perror("mkdtemp failed");
+			return false;
+		}
+	}
+
 	const char *source_filename = print_job->source_filename;
 	char *source_basename = strndup(print_job->source_filename, FILENAME_NCHARS);
 	char *source_basename_ptr = source_basename;
@@ -262,95 +370,108 @@ int main(int argc, char *argv[])
 	if (last_dot != NULL) {
 		*last_dot = '\0';
 	}
-	char *target_base = pdf2laser_format_string("%s/%s", tmpdir_name, source_basename);
+	char *target_base = (tmpdir_name == NULL) ?
+		strndup(source_basename, FILENAME_NCHARS) :
+		pdf2laser_format_string("%s/%s", tmpdir_name, source_basename);
 
 	free(source_basename_ptr);
 
-	char *target_pdf = pdf2laser_format_string("%s.pdf", target_base);
-	if (generate_pdf(source_filename, target_pdf)) {
-		perror("Failed to clone pdf file");
-		return -1;
+	// Regular files are read in place, only streamed input is captured
+	struct target *target_pdf = NULL;
+	char *source_pdf = generate_pdf_path(source_filename);
+	if (source_pdf == NULL) {
+		target_pdf = target_create(print_job, target_base, "pdf");
+		if (target_pdf == NULL || generate_pdf(source_filename, target_pdf->path)) {
+			perror("Failed to clone pdf file");
+			return -1;
+		}
+		source_pdf = strndup(target_pdf->path, FILENAME_NCHARS);
 	}
 
-	char *target_ps = pdf2laser_format_string("%s.ps", target_base);
-	if (generate_ps(target_pdf, target_ps)) {
-		perror("Failed to generate ps file");
-		return -1;
-	}
+	// Postscript sources are rendered as is, anything else is converted first
+	struct target *target_ps = NULL;
+	char *source_ps = source_pdf;
+	if (!source_is_postscript(source_pdf)) {
+		target_ps = target_create(print_job, target_base, "ps");
+		if (target_ps == NULL || generate_ps(source_pdf, target_ps->path)) {
+			perror("Failed to generate ps file");
+			return -1;
+		}
+		source_ps = strndup(target_ps->path, FILENAME_NCHARS);
+		free(source_pdf);
 
-	if (!print_job->debug) {
-		if (unlink(target_pdf)) {
+		if (target_pdf != NULL && target_destroy(print_job, target_pdf)) {
 			perror("Error deleting pdf file");
 			return -1;
 		}
+		target_pdf = NULL;
 	}
-	free(target_pdf);
 
-	char *target_eps = pdf2laser_format_string("%s.eps", target_base);
-	if (generate_eps(print_job, target_ps, target_eps)) {
-		perror("Failed to generate eps file");
+	char *prologue = generate_prologue(print_job, source_ps);
+	if (prologue == NULL) {
+		perror("Failed to generate prologue");
 		return -1;
 	}
 
-	if (!print_job->debug) {
-		if (unlink(target_ps)) {
-			perror("Error deleting ps file");
+	struct target *target_raster = NULL;
+	if (print_job_has_raster(print_job)) {
+		target_raster = target_create(print_job, target_base, "raster");
+		if (target_raster == NULL) {
+			perror("Failed to create raster file");
 			return -1;
 		}
 	}
-	free(target_ps);
 
-	char *target_bmp = pdf2laser_format_string("%s.bmp", target_base);
-	char *target_vector = pdf2laser_format_string("%s.vector", target_base);
-	if (execute_ghostscript(print_job, target_eps, target_bmp, target_vector)) {
+	if (execute_ghostscript(print_job, source_ps, prologue,
+	                        (target_raster != NULL) ? target_raster->path : NULL)) {
 		perror("Failed to execute ghostscript");
 		return -1;
 	}
 
-	if (!print_job->debug) {
-		if (unlink(target_eps)) {
-			perror("Error deleting eps file");
-			return -1;
-		}
+	free(prologue);
+	free(source_ps);
+
+	if (target_pdf != NULL && target_destroy(print_job, target_pdf)) {
+		perror("Error deleting pdf file");
+		return -1;
 	}
-	free(target_eps);
 
-	char *target_pjl = pdf2laser_format_string("%s.pjl", target_base);
-	if (generate_pjl(print_job, target_bmp, target_vector, target_pjl)) {
-		perror("Failed to generate pjl file");
+	if (target_ps != NULL && target_destroy(print_job, target_ps)) {
+		perror("Error deleting ps file");
 		return -1;
 	}
 
-	if (!print_job->debug) {
-		if (unlink(target_bmp)) {
-			perror("Error deleting bmp file");
-			return -1;
-		}
+	struct target *target_pjl = target_create(print_job, target_base, "pjl");
+	if (target_pjl == NULL ||
+	    generate_pjl(print_job, (target_raster != NULL) ? target_raster->path : NULL, target_pjl->path)) {
+		perror("Failed to generate pjl file");
+		return -1;
 	}
-	free(target_bmp);
 
-	if (!print_job->debug) {
-		if (unlink(target_vector)) {
-			perror("Error deleting vector file");
-			return -1;
-		}
+	if (target_raster != NULL && target_destroy(print_job, target_raster)) {
+		perror("Error deleting raster file");
+		return -1;
 	}
-	free(target_vector);
 
 	free(target_base);
 
-	if (printer_send(print_job, target_pjl)) {
+	if (printer_send(print_job, target_pjl->path)) {
 		perror("Failed to send job to printer");
 		return -1;
 	}
 
-	if (!print_job->debug) {
-		if (unlink(target_pjl)) {
-			perror("Error deleting pjl file");
+	if (target_destroy(print_job, target_pjl)) {
+		perror("Error deleting pjl file");
+		return -1;
+	}
+
+	if (tmpdir_name != NULL && !print_job->debug) {
+		if (rmdir(tmpdir_name) == -1) {
+			perror("Error deleting tmpdir");
 			return -1;
 		}
 	}
-	free(target_pjl);
+	free(tmpdir_name);
 
 	print_job_destroy(print_job);
 
@@ -358,13 +479,5 @@ int main(int argc, char *argv[])
 		preset_file_destroy(preset_files[index]);
 	}
 
-	if (!print_job->debug) {
-		if (rmdir(tmpdir_name) == -1) {
-			perror("Error deleting tmpdir");
-			return -1;
-		}
-	}
-	free(tmpdir_name);
-
 	return 0;
 }
@@ -1,18 +1,20 @@
 #include "pdf2laser_cli.h"
 #include <ctype.h>                    // for tolower
 #include <stddef.h>                   // for NULL, offsetof, size_t
-#include <stdint.h>                   // for int32_t, uint64_t, uint8_t
+#include <stdint.h>                   // for int32_t, uint32_t, uint64_t, uint8_t, INT32_MAX, UINT32_MAX
 #include <stdio.h>                    // for fprintf, sscanf, stderr, stdout
-#include <stdlib.h>                   // for atoi, exit, EXIT_FAILURE, calloc, free, EXIT_SUCCESS
+#include <stdlib.h>                   // for atoi, exit, EXIT_FAILURE, calloc, free, strtoll, EXIT_SUCCESS
 #include <string.h>                   // for strndup, strtok, strncmp, strncpy, strnlen
 #include "config.h"                   // for FILENAME_NCHARS, HOSTNAME_NCHARS, PACKAGE, VERSION
 #define OPTPARSE_IMPLEMENTATION
 #define OPTPARSE_API static
 #include "optparse.h"                 // for OPTPARSE_REQUIRED, optparse, OPTPARSE_NONE, optparse_long, optparse_init
+#include "type_kinematics.h"          // for kinematics_t
 #include "type_preset.h"              // for preset_apply_to_print_job, preset_t
 #include "type_preset_file.h"         // for preset_file_t
 #include "type_print_job.h"           // for print_job_t, print_job_append_new_vector_list_config, print_job_find_vector_list_config_by_rgb
 #include "type_raster.h"              // for raster_t
+#include "type_vector_list.h"         // for VECTOR_LIST_IMPROVE_MAX, VECTOR_LIST_PARTS_GROUP, VECTOR_LIST_PARTS_INNER, VECTOR_LIST_PARTS_NONE, VECTOR_LIST_SWEEPS_MAX
 #include "type_vector_list_config.h"  // for vector_list_config_t, vector_list_config_id_to_rgb
 
 static const struct optparse_long long_options[] = {
@@ -31,8 +33,15 @@ static const struct optparse_long long_options[] = {
 	{"vector-speed",          'v',  OPTPARSE_REQUIRED},
 	{"vector-frequency",      'f',  OPTPARSE_REQUIRED},
 	{"vector-passes",         'M',  OPTPARSE_REQUIRED},
+	{"vector-simplify",       'S',  OPTPARSE_REQUIRED},
 	{"no-vector-optimize",    'O',  OPTPARSE_NONE},
+	{"vector-parts",          'G',  OPTPARSE_REQUIRED},
+	{"vector-improve",        'I',  OPTPARSE_REQUIRED},
+	{"vector-sweeps",         'W',  OPTPARSE_REQUIRED},
 	{"no-vector-fallthrough", 'F',  OPTPARSE_NONE},
+	{"vector-binary",         'B',  OPTPARSE_NONE},
+	{"no-in-memory",          'T',  OPTPARSE_NONE},
+	{"threads",               't',  OPTPARSE_REQUIRED},
 	{"help",                  'h',  OPTPARSE_NONE},
 	{"version",               '@',  OPTPARSE_NONE},
 	{0}
@@ -69,10 +78,17 @@ static void usage(int rc, const char * const msg)
 		"  -v, --vector-speed=SPEED       Laser head speed for vector pass\n"
 		"  -f, --vector-frequency=FREQ    Laser frequency for vector pass\n"
 		"  -M, --vector-passes=PASSES     Number of times to repeat vector pass\n"
+		"  -S, --vector-simplify=TOL      Drop vector points within TOL dots of the path\n"
 		"  -O, --no-vector-optimize       Disable vector optimization\n"
+		"  -G, --vector-parts=MODE        Order vectors part by part: None, Group, or Inner first\n"
+		"  -I, --vector-improve=MS        Spend up to MS milliseconds shortening transit\n"
+		"  -W, --vector-sweeps=N          Make up to N passes shortening transit, reproducibly\n"
 		"  -F, --no-vector-fallthrough    Disable automatic vector configuration\n"
+		"  -B, --vector-binary            Trace vectors with the compact binary protocol\n"
 		"\n"
 		"Generic program options:\n"
+		"  -T, --no-in-memory             Stage intermediate files in the temporary directory\n"
+		"  -t, --threads=N                Optimize vector layers on up to N threads (default 0, one per core)\n"
 		"  -D, --debug                    Enable debug mode\n"
 		"  -h, --help                     Output a usage message and exit\n"
 		"      --version                  Output the version number and exit\n"
@@ -93,15 +109,20 @@ static int32_t vector_config_set_param_offset(print_job_t *print_job, char *opta
 
 	char *token = strtok(s, ",");
 	while (token) {
-		uint64_t values[2] = {0, 0};
-		int32_t rc = sscanf(token, "%lx=%lu", &values[0], &values[1]);
-		if (rc != 2) {
+		uint64_t id = 0;
+		int32_t offset = 0;
+		int32_t rc = sscanf(token, "%lx=%n", &id, &offset);
+
+		// Values are never negative, strtoll keeps a sign from wrapping round
+		char *value_end = NULL;
+		long long value = (rc == 1 && offset > 0) ? strtoll(token + offset, &value_end, 10) : -1;
+		if (value < 0 || value > INT32_MAX || value_end == token + offset || *value_end != '\0') {
 			free(s_ptr);
 			return -1;
 		}
 
 		int32_t red, green, blue;
-		vector_list_config_id_to_rgb(values[0], &red, &green, &blue);
+		vector_list_config_id_to_rgb(id, &red, &green, &blue);
 
 		vector_list_config_t *vector_list_config = print_job_find_vector_list_config_by_rgb(print_job, red, green, blue);
 		if (vector_list_config == NULL)
@@ -109,7 +130,7 @@ static int32_t vector_config_set_param_offset(print_job_t *print_job, char *opta
 
 		uint8_t *base = (uint8_t *)(vector_list_config);
 		int32_t *field = (int32_t *)(base + FIELD);
-		*field = (int32_t)values[1];
+		*field = (int32_t)value;
 
 		token = strtok(NULL, ",");
 	}
@@ -134,6 +155,11 @@ static int32_t vector_config_set_param_multipass(print_job_t *print_job, char *o
 	return vector_config_set_param_offset(print_job, optarg, offsetof(vector_list_config_t, multipass));
 }
 
+static int32_t vector_config_set_param_simplify(print_job_t *print_job, char *optarg)
+{
+	return vector_config_set_param_offset(print_job, optarg, offsetof(vector_list_config_t, simplify));
+}
+
 static int32_t vector_config_set_param_frequency(print_job_t *print_job, char *optarg)
 {
 	return vector_config_set_param_offset(print_job, optarg, offsetof(vector_list_config_t, frequency));
@@ -173,6 +199,34 @@ static void range_checks(print_job_t *print_job)
 		print_job->raster->screen_size = 1;
 	}
 
+	if (print_job->kinematics->speed < 1) {
+		print_job->kinematics->speed = 1;
+	}
+
+	if (print_job->kinematics->acceleration < 1) {
+		print_job->kinematics->acceleration = 1;
+	}
+
+	if (print_job->kinematics->corner < 0) {
+		print_job->kinematics->corner = 0;
+	}
+
+	if (print_job->kinematics->precision < 1) {
+		print_job->kinematics->precision = 1;
+	}
+
+	if (print_job->vector_improve > VECTOR_LIST_IMPROVE_MAX) {
+		print_job->vector_improve = VECTOR_LIST_IMPROVE_MAX;
+	}
+
+	if (print_job->vector_sweeps > VECTOR_LIST_SWEEPS_MAX) {
+		print_job->vector_sweeps = VECTOR_LIST_SWEEPS_MAX;
+	}
+
+	if (print_job->vector_parts != VECTOR_LIST_PARTS_GROUP && print_job->vector_parts != VECTOR_LIST_PARTS_INNER) {
+		print_job->vector_parts = VECTOR_LIST_PARTS_NONE;
+	}
+
 	for (vector_list_config_t *current_config = print_job->configs; current_config != NULL; current_config = current_config->next) {
 		if (current_config->power > 100) {
 			current_config->power = 100;
@@ -294,6 +348,11 @@ bool pdf2laser_optparse(print_job_t *print_job, preset_file_t **preset_files, si
 				usage(EXIT_FAILURE, "unable to parse multipass");
 			break;
 
+		case 'S':
+			if (vector_config_set_param_simplify(print_job, options.optarg) < 0)
+				usage(EXIT_FAILURE, "unable to parse vector-simplify");
+			break;
+
 		case 'm':
 			print_job->raster->mode = tolower(*options.optarg);
 			break;
@@ -315,10 +374,49 @@ bool pdf2laser_optparse(print_job_t *print_job, preset_file_t **preset_files, si
 			print_job->vector_optimize = false;
 			break;
 
+		case 'G':
+			print_job->vector_parts = tolower(*options.optarg);
+			break;
+
+		case 'I': {
+			char *end = NULL;
+			long long improve = strtoll(options.optarg, &end, 10);
+			if (end == options.optarg || *end != '\0' || improve < 0)
+				usage(EXIT_FAILURE, "unable to parse vector-improve");
+			print_job->vector_improve = (improve > UINT32_MAX) ? UINT32_MAX : (uint32_t)improve;
+			break;
+		}
+
+		case 'W': {
+			char *end = NULL;
+			long long sweeps = strtoll(options.optarg, &end, 10);
+			if (end == options.optarg || *end != '\0' || sweeps < 0)
+				usage(EXIT_FAILURE, "unable to parse vector-sweeps");
+			print_job->vector_sweeps = (sweeps > UINT32_MAX) ? UINT32_MAX : (uint32_t)sweeps;
+			break;
+		}
+
 		case 'F':
 			print_job->vector_fallthrough = false;
 			break;
 
+		case 'B':
+			print_job->vector_binary = true;
+			break;
+
+		case 'T':
+			print_job->in_memory = false;
+			break;
+
+		case 't': {
+			char *end = NULL;
+			long long threads = strtoll(options.optarg, &end, 10);
+			if (end == options.optarg || *end != '\0' || threads < 0)
+				usage(EXIT_FAILURE, "unable to parse threads");
+			print_job->threads = (threads > UINT32_MAX) ? UINT32_MAX : (uint32_t)threads;
+			break;
+		}
+
 		case 'h':
 			usage(EXIT_SUCCESS, "");
 			break;
@@ -338,6 +436,10 @@ bool pdf2laser_optparse(print_job_t *print_job, preset_file_t **preset_files, si
 
 	range_checks(print_job);
 
+	// Intermediate files are kept around for inspection in debug mode
+	if (print_job->debug)
+		print_job->in_memory = false;
+
 	// Skip any of the processed arguments
 	argc -= options.optind;
 	argv += options.optind;
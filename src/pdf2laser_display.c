@@ -0,0 +1,370 @@
+#include "pdf2laser_display.h"
+#include <ghostscript/gdevdsp.h>  // for display_callback, DISPLAY_ALPHA_NONE, DISPLAY_BIGENDIAN, DISPLAY_COLORS_GRAY, DISPLAY_COLORS_NATIVE, DISPLAY_COLORS_RGB, DISPLAY_DEPTH_1, DISPLAY_DEPTH_8, DISPLAY_LITTLEENDIAN, DISPLAY_TOPFIRST, DISPLAY_VERSION_MAJOR, DISPLAY_VERSION_MINOR
+#include <ghostscript/iapi.h>     // for gsapi_set_display_callback
+#include <inttypes.h>             // for PRId32, PRIxPTR
+#include <pthread.h>              // for pthread_create, pthread_join
+#include <stdbool.h>              // for false, true, bool
+#include <stddef.h>               // for size_t
+#include <stdint.h>               // for int32_t, uint8_t, uintptr_t
+#include <stdio.h>                // for fprintf, perror, stderr, NULL, FILE
+#include <stdlib.h>               // for calloc, free
+#include <string.h>               // for memcpy
+#include "pdf2laser_generator.h"  // for generate_raster, generate_raster_footer, generate_raster_header, generate_raster_row
+#include "pdf2laser_util.h"       // for pdf2laser_format_string
+#include "type_band_queue.h"      // for band_queue_acquire, band_queue_close, band_queue_create, band_queue_destroy, band_queue_peek, band_queue_publish, band_queue_release
+#include "type_bitmap.h"          // for bitmap_t, bitmap_create, bitmap_destroy
+#include "type_print_job.h"       // for print_job_t
+#include "type_raster.h"          // for raster_mode, RASTER_MODE_COLOR, RASTER_MODE_GREY_SCALE
+
+/**
+ * Pixel layout requested from the display device. These mirror what the
+ * bmp16m, bmpgray and bmpmono devices used to produce, so the raster
+ * generator sees the same bytes: BGR for colour, 0 = black for grey and
+ * 1 = black for mono.
+ */
+static unsigned int display_sink_format(raster_mode mode)
+{
+	switch (mode) {
+	case RASTER_MODE_COLOR:
+		return DISPLAY_COLORS_RGB | DISPLAY_ALPHA_NONE | DISPLAY_DEPTH_8 |
+			DISPLAY_LITTLEENDIAN | DISPLAY_TOPFIRST;
+	case RASTER_MODE_GREY_SCALE:
+		return DISPLAY_COLORS_GRAY | DISPLAY_ALPHA_NONE | DISPLAY_DEPTH_8 |
+			DISPLAY_BIGENDIAN | DISPLAY_TOPFIRST;
+	case RASTER_MODE_MONO:
+	case RASTER_MODE_NONE:
+	default:
+		return DISPLAY_COLORS_NATIVE | DISPLAY_ALPHA_NONE | DISPLAY_DEPTH_1 |
+			DISPLAY_BIGENDIAN | DISPLAY_TOPFIRST;
+	}
+}
+
+static int display_sink_open(__attribute__ ((unused)) void *handle, __attribute__ ((unused)) void *device)
+{
+	return 0;
+}
+
+static int display_sink_preclose(__attribute__ ((unused)) void *handle, __attribute__ ((unused)) void *device)
+{
+	return 0;
+}
+
+static int display_sink_close(__attribute__ ((unused)) void *handle, __attribute__ ((unused)) void *device)
+{
+	return 0;
+}
+
+static int display_sink_presize(void *handle, __attribute__ ((unused)) void *device, __attribute__ ((unused)) int width, __attribute__ ((unused)) int height, __attribute__ ((unused)) int raster, unsigned int format)
+{
+	display_sink_t *self = handle;
+
+	// refuse any layout other than the one we asked for
+	return (format == display_sink_format(self->print_job->raster->mode)) ? 0 : -1;
+}
+
+static int display_sink_size(void *handle, __attribute__ ((unused)) void *device, int width, int height, int raster, __attribute__ ((unused)) unsigned int format, unsigned char *pimage)
+{
+	display_sink_t *self = handle;
+
+	// pimage is NULL in streaming mode, bands are supplied on request
+	self->image = pimage;
+	self->width = width;
+	self->height = height;
+	self->raster = raster;
+
+	return 0;
+}
+
+static int display_sink_sync(__attribute__ ((unused)) void *handle, __attribute__ ((unused)) void *device)
+{
+	return 0;
+}
+
+static int display_sink_page(void *handle, __attribute__ ((unused)) void *device, __attribute__ ((unused)) int copies, __attribute__ ((unused)) int flush)
+{
+	display_sink_t *self = handle;
+
+	// only the first page is engraved
+	if (self->bitmap != NULL || self->image == NULL)
+		return 0;
+
+	self->bitmap = bitmap_create(self->width, self->height, self->raster);
+	if (self->bitmap == NULL) {
+		fprintf(stderr, "Unable to allocate %"PRId32"x%"PRId32" bitmap\n", self->width, self->height);
+		return -1;
+	}
+
+	memcpy(self->bitmap->data, self->image, (size_t)self->height * (size_t)self->raster);
+
+	return 0;
+}
+
+static int display_sink_update(__attribute__ ((unused)) void *handle, __attribute__ ((unused)) void *device, __attribute__ ((unused)) int x, __attribute__ ((unused)) int y, __attribute__ ((unused)) int w, __attribute__ ((unused)) int h)
+{
+	return 0;
+}
+
+/**
+ * Raster encoder thread. Encodes bands as they are published, from the
+ * bottom of the page up, which is the order the laser expects them in.
+ */
+static void *display_sink_encode(void *handle)
+{
+	display_sink_t *self = handle;
+	print_job_t *print_job = self->print_job;
+
+	int rc = generate_raster_header(print_job, self->raster_fh, self->width, self->height);
+
+	char dir = 0;
+	uint8_t *band;
+	int32_t band_y, band_rows;
+	while ((band = band_queue_peek(self->band_queue, &band_y, &band_rows)) != NULL) {
+		// keep draining on errors so the renderer never blocks
+		for (int32_t row = band_rows - 1; row >= 0 && rc == 0; row--) {
+			rc = generate_raster_row(print_job, self->raster_fh, band + (size_t)row * self->band_raster,
+			                         self->width, band_y + row, 0, &dir);
+		}
+		band_queue_release(self->band_queue);
+	}
+
+	if (rc == 0)
+		rc = generate_raster_footer(print_job, self->raster_fh);
+
+	self->encoder_rc = rc;
+
+	return NULL;
+}
+
+static int display_sink_stream_start(display_sink_t *self)
+{
+	int32_t row_bytes = (self->print_job->raster->mode == RASTER_MODE_GREY_SCALE) ?
+		self->width : (self->width + 7) / 8;
+
+	self->band_raster = (row_bytes + 7) / 8 * 8;
+	self->band_rows = DISPLAY_SINK_BAND_NBYTES / self->band_raster;
+	if (self->band_rows < 1)
+		self->band_rows = 1;
+	self->band_next = self->height;
+
+	self->band_queue = band_queue_create(DISPLAY_SINK_BANDS, (size_t)self->band_rows * self->band_raster);
+	if (self->band_queue == NULL) {
+		fprintf(stderr, "Unable to allocate raster bands\n");
+		self->encoder_rc = -1;
+		return -1;
+	}
+
+	if (pthread_create(&self->encoder, NULL, display_sink_encode, self)) {
+		perror("pthread_create failed");
+		self->encoder_rc = -1;
+		return -1;
+	}
+	self->encoding = true;
+
+	return 0;
+}
+
+static int display_sink_stream_stop(display_sink_t *self)
+{
+	self->state = DISPLAY_SINK_DONE;
+
+	if (self->band_queue != NULL)
+		band_queue_close(self->band_queue);
+
+	if (self->encoding) {
+		pthread_join(self->encoder, NULL);
+		self->encoding = false;
+	}
+
+	return self->encoder_rc;
+}
+
+/**
+ * Hand ghostscript the next band to render. Each call also means the band
+ * requested by the previous call is complete, so it is passed on to the
+ * encoder thread before blocking for a free slot.
+ */
+static int display_sink_rectangle_request(void *handle, __attribute__ ((unused)) void *device, void **memory, int *ox, int *oy, int *raster, int *plane_raster, int *x, int *y, int *w, int *h)
+{
+	display_sink_t *self = handle;
+
+	if (self->band_pending) {
+		band_queue_publish(self->band_queue, self->pending_y, self->pending_rows);
+		self->band_pending = false;
+	}
+
+	uint8_t *band = NULL;
+	switch (self->state) {
+	case DISPLAY_SINK_IDLE:
+		self->state = DISPLAY_SINK_STREAMING;
+		if (display_sink_stream_start(self))
+			break;
+		// fall through
+	case DISPLAY_SINK_STREAMING:
+		if (self->band_next > 0)
+			band = band_queue_acquire(self->band_queue);
+		break;
+	case DISPLAY_SINK_DONE:
+	default:
+		break;
+	}
+
+	if (band == NULL) {
+		// page complete, or only pages after the first are left
+		if (self->state == DISPLAY_SINK_STREAMING)
+			display_sink_stream_stop(self);
+
+		*memory = NULL;
+		*w = 0;
+		*h = 0;
+		return 0;
+	}
+
+	int32_t rows = (self->band_next < self->band_rows) ? self->band_next : self->band_rows;
+	self->band_next -= rows;
+
+	self->band_pending = true;
+	self->pending_y = self->band_next;
+	self->pending_rows = rows;
+
+	*memory = band;
+	*ox = 0;
+	*oy = self->band_next;
+	*raster = self->band_raster;
+	*plane_raster = 0;
+	*x = 0;
+	*y = self->band_next;
+	*w = self->width;
+	*h = rows;
+
+	return 0;
+}
+
+static display_callback display_sink_page_callback = {
+	.size = sizeof(display_callback),
+	.version_major = DISPLAY_VERSION_MAJOR,
+	.version_minor = DISPLAY_VERSION_MINOR,
+	.display_open = display_sink_open,
+	.display_preclose = display_sink_preclose,
+	.display_close = display_sink_close,
+	.display_presize = display_sink_presize,
+	.display_size = display_sink_size,
+	.display_sync = display_sink_sync,
+	.display_page = display_sink_page,
+	.display_update = display_sink_update,
+	.display_memalloc = NULL,
+	.display_memfree = NULL,
+};
+
+#if DISPLAY_VERSION_MAJOR >= 3
+static display_callback display_sink_band_callback = {
+	.size = sizeof(display_callback),
+	.version_major = DISPLAY_VERSION_MAJOR,
+	.version_minor = DISPLAY_VERSION_MINOR,
+	.display_open = display_sink_open,
+	.display_preclose = display_sink_preclose,
+	.display_close = display_sink_close,
+	.display_presize = display_sink_presize,
+	.display_size = display_sink_size,
+	.display_sync = display_sink_sync,
+	.display_page = display_sink_page,
+	.display_update = display_sink_update,
+	.display_memalloc = NULL,
+	.display_memfree = NULL,
+	.display_separation = NULL,
+	.display_adjust_band_height = NULL,
+	.display_rectangle_request = display_sink_rectangle_request,
+};
+#endif
+
+display_sink_t *display_sink_create(print_job_t *print_job, FILE *raster_fh)
+{
+	display_sink_t *display_sink = calloc(1, sizeof(display_sink_t));
+	if (display_sink == NULL)
+		return NULL;
+
+	display_sink->print_job = print_job;
+	display_sink->raster_fh = raster_fh;
+	display_sink->image = NULL;
+	display_sink->bitmap = NULL;
+	display_sink->state = DISPLAY_SINK_IDLE;
+	display_sink->band_queue = NULL;
+	display_sink->band_pending = false;
+	display_sink->encoding = false;
+	display_sink->encoder_rc = 0;
+
+	return display_sink;
+}
+
+display_sink_t *display_sink_destroy(display_sink_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	display_sink_stream_stop(self);
+	band_queue_destroy(self->band_queue);
+	bitmap_destroy(self->bitmap);
+
+	free(self);
+
+	return NULL;
+}
+
+/**
+ * Whether rows are encoded while ghostscript renders. Colour mode needs one
+ * pass over the whole page per colour, so it always renders a full page.
+ */
+bool display_sink_streaming(display_sink_t *self)
+{
+#if DISPLAY_VERSION_MAJOR >= 3
+	return self->print_job->raster->mode != RASTER_MODE_COLOR;
+#else
+	(void)self;
+	return false;
+#endif
+}
+
+/**
+ * Register the sink's callbacks with a ghostscript instance. The instance
+ * must also be given the arguments from display_sink_format_arg and
+ * display_sink_handle_arg along with -sDEVICE=display.
+ */
+int display_sink_attach(display_sink_t *self, void *minst)
+{
+#if DISPLAY_VERSION_MAJOR >= 3
+	if (display_sink_streaming(self))
+		return gsapi_set_display_callback(minst, &display_sink_band_callback);
+#endif
+	return gsapi_set_display_callback(minst, &display_sink_page_callback);
+}
+
+char *display_sink_format_arg(display_sink_t *self)
+{
+	return pdf2laser_format_string("-dDisplayFormat=%u", display_sink_format(self->print_job->raster->mode));
+}
+
+char *display_sink_handle_arg(display_sink_t *self)
+{
+	return pdf2laser_format_string("-sDisplayHandle=16#%"PRIxPTR"", (uintptr_t)self);
+}
+
+/**
+ * Complete the raster section once ghostscript is done: wait for the
+ * encoder thread in streaming mode, or encode the captured page otherwise.
+ */
+int display_sink_finish(display_sink_t *self)
+{
+	if (display_sink_streaming(self)) {
+		if (self->state == DISPLAY_SINK_IDLE) {
+			fprintf(stderr, "No page was rendered, cannot generate raster.\n");
+			return -1;
+		}
+		return display_sink_stream_stop(self);
+	}
+
+	if (self->bitmap == NULL) {
+		fprintf(stderr, "No page was rendered, cannot generate raster.\n");
+		return -1;
+	}
+
+	return generate_raster(self->print_job, self->raster_fh, self->bitmap);
+}
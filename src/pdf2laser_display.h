@@ -0,0 +1,76 @@
+#ifndef __PDF2LASER_DISPLAY_H__
+#define __PDF2LASER_DISPLAY_H__ 1
+
+#include <pthread.h>          // for pthread_t
+#include <stdbool.h>          // for bool
+#include <stdint.h>           // for int32_t, uint8_t
+#include <stdio.h>            // for FILE
+#include "type_band_queue.h"  // for band_queue_t
+#include "type_bitmap.h"      // for bitmap_t
+#include "type_print_job.h"   // for print_job_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+// Size of a single band handed to ghostscript in streaming mode.
+#define DISPLAY_SINK_BAND_NBYTES (1 << 20)
+
+// Number of bands which may be rendered ahead of the raster encoder.
+#define DISPLAY_SINK_BANDS (4)
+
+typedef enum {
+	DISPLAY_SINK_IDLE,       // waiting for the first page
+	DISPLAY_SINK_STREAMING,  // bands of the first page are being rendered
+	DISPLAY_SINK_DONE,       // the first page has been rendered
+} display_sink_state;
+
+typedef struct display_sink display_sink_t;
+struct display_sink {
+	print_job_t *print_job;
+
+	// encoded raster section
+	FILE *raster_fh;
+
+	int32_t width;
+	int32_t height;
+
+	// full page mode: page buffer handed out by ghostscript and a copy of
+	// the first completed page
+	uint8_t *image;
+	int32_t raster;
+	bitmap_t *bitmap;
+
+	// streaming mode: bands rendered from the bottom of the page up
+	display_sink_state state;
+	band_queue_t *band_queue;
+	int32_t band_raster;
+	int32_t band_rows;
+	int32_t band_next;
+	bool band_pending;
+	int32_t pending_y;
+	int32_t pending_rows;
+
+	bool encoding;
+	pthread_t encoder;
+	int encoder_rc;
+};
+
+display_sink_t *display_sink_create(print_job_t *print_job, FILE *raster_fh);
+display_sink_t *display_sink_destroy(display_sink_t *self);
+
+bool display_sink_streaming(display_sink_t *self);
+int display_sink_attach(display_sink_t *self, void *minst);
+char *display_sink_format_arg(display_sink_t *self);
+char *display_sink_handle_arg(display_sink_t *self);
+
+int display_sink_finish(display_sink_t *self);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
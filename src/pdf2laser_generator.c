@@ -2,45 +2,58 @@
 #include <fcntl.h>                    // for open, O_RDONLY, SEEK_SET
 #include <ghostscript/gserrors.h>     // for gs_error_Quit
 #include <ghostscript/iapi.h>         // for gsapi_delete_instance, gsapi_exit, gsapi_init_with_args, gsapi_new_instance, gsapi_set_arg_encoding, GS_ARG_ENCODING_UTF8
-#include <inttypes.h>                 // for PRId32
-#include <stdbool.h>                  // for bool, false
+#include <inttypes.h>                 // for PRId32, PRIu32
+#include <math.h>                     // for INFINITY
+#include <pthread.h>                  // for pthread_create, pthread_join, pthread_mutex_lock, pthread_mutex_unlock, pthread_t
+#include <stdbool.h>                  // for bool, false, true
 #include <stdint.h>                   // for int32_t, uint8_t, uint32_t
 #include <stdio.h>                    // for fprintf, fclose, fopen, fread, FILE, fputc, sscanf, NULL, fileno, perror, printf, getline, stderr, size_t, fflush, fseek, fwrite, snprintf, stdin
 #include <stdlib.h>                   // for free, calloc
-#include <string.h>                   // for memset, strncmp, strndup
+#include <string.h>                   // for memcpy, strncmp, strndup
 #include <strings.h>                  // for strncasecmp
-#include <unistd.h>                   // for close, ssize_t
+#include <sys/stat.h>                 // for fstat, stat, S_ISREG
+#include <unistd.h>                   // for close, ssize_t, sysconf, STDIN_FILENO, _SC_NPROCESSORS_ONLN
 #include "config.h"                   // for GS_ARG_NCHARS
-#include "pdf2laser_util.h"           // for pdf2laser_sendfile
-#include "type_point.h"               // for point_t, point_compare
-#include "type_print_job.h"           // for print_job_t, print_job_clone_last_vector_list_config, print_job_find_vector_list_config_by_rgb, PRINT_JOB_MODE_COMBINED, PRINT_JOB_MODE_RASTER, PRINT_JOB_MODE_VECTOR
+#include "pdf2laser_util.h"           // for pdf2laser_copyfd, pdf2laser_fd_path, pdf2laser_sendfile
+#include "type_bitmap.h"              // for bitmap_t, bitmap_row
+#include "type_hpgl_buffer.h"         // for hpgl_buffer_t, hpgl_buffer_add_pair, hpgl_buffer_append, hpgl_buffer_clear, hpgl_buffer_create, hpgl_buffer_destroy, hpgl_buffer_write
+#include "type_path_list.h"           // for path_list_t, path_list_chain, path_list_destroy, path_list_entry_time, path_list_improve, path_list_optimize, path_list_optimize_parts, path_list_rotate, path_list_to_vector_list
+#include "type_point.h"               // for point_t, point_equal
+#include "type_print_job.h"           // for print_job_t, print_job_has_raster, print_job_has_vector
 #include "type_raster.h"              // for raster_t
-#include "type_vector.h"              // for vector_t, vector_create
-#include "type_vector_list.h"         // for vector_list_append, vector_list_contains, vector_list_t, vector_list_optimize
-#include "type_vector_list_config.h"  // for vector_list_config_t, vector_list_config_id_to_rgb
+#include "type_vector.h"              // for vector_t
+#include "type_vector_list.h"         // for vector_list_t, vector_list_destroy, vector_list_get, vector_list_simplify, vector_list_stats, vector_list_trim_overlaps, VECTOR_LIST_PARTS_INNER, VECTOR_LIST_PARTS_NONE
+#include "type_vector_list_config.h"  // for vector_list_config_t
 
 /**
- * Convert a big endian value stored in the array starting at the given pointer
- * position to its little endian value.
+ * Find a path ghostscript can read the source pdf from in place. Regular
+ * files, including a stdin redirected from one, need no copy.
  *
- * @param position the starting location for the conversion. Each successive
- * unsigned byte is upto nbytes is considered part of the value.
- * @param nbytes the number of successive bytes to convert.
+ * @param source_pdf the source filename, or "stdin".
  *
- * @return An integer containing the little endian value of the successive
- * bytes.
+ * @return A newly allocated path, or NULL if the source is a stream which has
+ * to be captured with generate_pdf first.
  */
-static int32_t big_to_little_endian(uint8_t *position, size_t nbytes)
+char *generate_pdf_path(const char *source_pdf)
 {
-	int32_t result = 0;
+	struct stat source_stat;
 
-	for (size_t i = 0; i < nbytes; i++)
-		result += *(position + i) << (8 * i);
+	if (strncasecmp(source_pdf, "stdin", 5) == 0) {
+		if (fstat(STDIN_FILENO, &source_stat) == 0 && S_ISREG(source_stat.st_mode))
+			return pdf2laser_fd_path(STDIN_FILENO);
+		return NULL;
+	}
 
-	return result;
-}
+	if (stat(source_pdf, &source_stat) == 0 && S_ISREG(source_stat.st_mode))
+		return strndup(source_pdf, GS_ARG_NCHARS);
 
+	return NULL;
+}
 
+/**
+ * Capture a streamed source pdf (a pipe on stdin, a fifo, ...) into
+ * target_pdf so ghostscript can seek in it.
+ */
 int generate_pdf(const char *source_pdf, const char *target_pdf)
 {
 	FILE *target_pdf_fh = fopen(target_pdf, "w");
@@ -49,23 +62,24 @@ int generate_pdf(const char *source_pdf, const char *target_pdf)
 		return -1;
 	}
 
+	int rc;
 	if (strncasecmp(source_pdf, "stdin", 5) == 0) {
-		uint8_t buffer[102400];
-		size_t rc;
-		while ((rc = fread(buffer, 1, 102400, stdin)) > 0) {
-			fwrite(buffer, 1, rc, target_pdf_fh);
-			memset(buffer, 1, 102400);
-		}
+		rc = pdf2laser_copyfd(fileno(target_pdf_fh), STDIN_FILENO);
 	}
 	else {
 		int source_pdf_fno = open(source_pdf, O_RDONLY);
-		pdf2laser_sendfile(fileno(target_pdf_fh), source_pdf_fno);
+		if (source_pdf_fno < 0) {
+			perror(source_pdf);
+			fclose(target_pdf_fh);
+			return -1;
+		}
+		rc = pdf2laser_copyfd(fileno(target_pdf_fh), source_pdf_fno);
 		close(source_pdf_fno);
 	}
 
 	fclose(target_pdf_fh);
 
-	return 0;
+	return rc;
 }
 
 
@@ -118,120 +132,240 @@ int generate_ps(const char *target_pdf, const char *target_ps)
 
 
 /**
- * Convert the given postscript file (ps) converting it to an encapsulated
- * postscript file (eps).
- *
- * @param ps_file a file handle pointing to an opened postscript file that
- * is to be converted.
- * @param eps_file a file handle pointing to the opened encapsulated
- * postscript file to store the result.
+ * Check whether the given source is already postscript, in which case it can
+ * be rendered directly without a ps2write pass.
+ */
+bool source_is_postscript(const char *source)
+{
+	char magic[2];
+
+	FILE *source_fh = fopen(source, "r");
+	if (source_fh == NULL)
+		return false;
+
+	size_t rc = fread(magic, 1, sizeof(magic), source_fh);
+	fclose(source_fh);
+
+	return rc == sizeof(magic) && strncmp(magic, "%!", 2) == 0;
+}
+
+
+/**
+ * Write the part of the prologue which hooks stroke, printing the path of
+ * each stroke in a matched colour to stdout instead of painting it. Curves
+ * are printed as their control points and flattened by the vector parser.
  *
- * @return Return true if the function completes its task, false otherwise.
+ * @param print_job the print job providing the vector configs.
+ * @param prologue_fh stream the prologue is being written to.
  */
-int generate_eps(print_job_t *print_job, char *target_ps_file, char *target_eps_file)
+static void generate_prologue_vector(print_job_t *print_job, FILE *prologue_fh)
 {
-	FILE *target_ps_fh = fopen(target_ps_file, "r");
-	FILE *target_eps_fh = fopen(target_eps_file, "w");
+	if (print_job->vector_binary) {
+		/* Points are batched into one array per subpath, or per chunk of a
+		 * long one, and printed as a binary object sequence whose tag is the
+		 * record type. The pending record type lives in a dictionary the
+		 * hook holds on to, whatever dictionary is current when it runs.
+		 */
+		fprintf
+			(prologue_fh,
+			 "1 setobjectformat "
+			 "/pdf2laser_state 1 dict def "
+			 "//pdf2laser_state /tag 77 put "
+			 "/pdf2laser_flush {"
+			 "counttomark 0 gt {counttomark array astore //pdf2laser_state /tag get printobject} if "
+			 "//pdf2laser_state /tag 76 put"
+			 "} bind def"
+			 "\n");
+	}
 
-	char *line = NULL;
-	size_t length = 0;
-	ssize_t length_read;
+	if (!print_job->vector_fallthrough) {
+		/* Configured colours are keyed on their packed id, so matching a
+		 * stroke is a single lookup however many colours there are.
+		 */
+		int32_t config_count = 0;
+		for (vector_list_config_t *vector_list_config = print_job->configs;
+		     vector_list_config != NULL;
+		     vector_list_config = vector_list_config->next) {
+			config_count += 1;
+		}
 
-	while ((length_read = getline(&line, &length, target_ps_fh)) != -1) {
-		fprintf(target_eps_fh, "%s", line);
+		fprintf(prologue_fh, "/pdf2laser_colors %"PRId32" dict def", (config_count > 0) ? config_count : 1);
 
-		if (*line != '%') {
-			break;
+		for (vector_list_config_t *vector_list_config = print_job->configs;
+		     vector_list_config != NULL;
+		     vector_list_config = vector_list_config->next) {
+			fprintf(prologue_fh, " //pdf2laser_colors %"PRIu32" true put", vector_list_config->id);
 		}
-		else if (strncmp(line, "%!", 2) == 0) {
-			fprintf(target_eps_fh, "/=== {(        ) cvs print} def\n/stroke { "); // print a number
 
-			if (print_job->vector_fallthrough) {
-				fprintf(target_eps_fh, "true ");
-			} else {
-				for (vector_list_config_t *vector_list_config = print_job->configs;
-				     vector_list_config != NULL;
-				     vector_list_config = vector_list_config->next) {
-
-					int32_t red, green, blue;
-					vector_list_config_id_to_rgb(vector_list_config->id, &red, &green, &blue);
-
-					fprintf(target_eps_fh, "currentrgbcolor "
-					        "255 mul round cvi %"PRId32" eq "
-					        "exch "
-					        "255 mul round cvi %"PRId32" eq "
-					        "and exch "
-					        "255 mul round cvi %"PRId32" eq "
-					        "and ", blue, green, red);
-
-					if (vector_list_config->index > 0) {
-						fprintf(target_eps_fh, "or ");
-					}
-				}
-			}
+		fprintf(prologue_fh, "\n");
+	}
 
-			fprintf
-				(target_eps_fh,
-				 "{"
-				 // Display color codes
-				 "(P)=== "
-				 "currentrgbcolor "
-				 "(,)=== "
-				 "255 mul round cvi === "
-				 "(,)=== "
-				 "255 mul round cvi === "
-				 "(,)=== "
-				 "255 mul round cvi = "
-				 "flattenpath "
-				 "{ "
-				 // moveto
-				 "transform (M)=== "
-				 "round cvi === "
-				 "(,)=== "
-				 "round cvi ="
-				 "}{"
-				 // lineto
-				 "transform(L)=== "
-				 "round cvi === "
-				 "(,)=== "
-				 "round cvi ="
-				 "}{"
-				 // curveto (not implemented)
-				 "}{"
-				 // closepath
-				 "(C)="
-				 "}"
-				 "pathforall newpath"
-				 "}"
-				 "{"
-				 // For debugging purposes, draw the line normally
-				 "stroke"
-				 "}"
-				 "ifelse"
-				 "}bind def"
-				 "\n"
-				 "/showpage {(X)= showpage}bind def"
-				 "\n");
-
-			if (print_job->raster->mode != 'c' && print_job->raster->mode != 'g') {
-				if (print_job->raster->screen_size == 0) {
-					fprintf(target_eps_fh, "{0.5 ge{1}{0}ifelse}settransfer\n");
-				}
-				else {
-					uint32_t screen_size = print_job->raster->screen_size;
-					if (print_job->raster->resolution >= 600) {
-						// adjust for overprint
-						fprintf(target_eps_fh,
-						        "{dup 0 ne{%"PRId32" %"PRId32" div add}if}settransfer\n",
-						        print_job->raster->resolution / 600, screen_size);
-					}
-					fprintf(target_eps_fh, "%"PRId32" 30{%s}setscreen\n", print_job->raster->resolution / screen_size,
-					        (print_job->raster->screen_size > 0) ? "pop abs 1 exch sub" :
-					        "180 mul cos exch 180 mul cos add 2 div");
-				}
+	fprintf(prologue_fh, "/=== {(        ) cvs print} def\n/stroke { "); // print a number
+
+	if (print_job->vector_fallthrough) {
+		fprintf(prologue_fh, "true ");
+	} else {
+		// red << 16 + green << 8 + blue, as vector_list_config_rgb_to_id
+		fprintf(prologue_fh, "//pdf2laser_colors "
+		        "currentrgbcolor "
+		        "255 mul round cvi "
+		        "exch "
+		        "255 mul round cvi 256 mul add "
+		        "exch "
+		        "255 mul round cvi 65536 mul add "
+		        "known ");
+	}
+
+	if (print_job->vector_binary) {
+		fprintf
+			(prologue_fh,
+			 "{"
+			 // Display color codes
+			 "currentrgbcolor 3 {255 mul round cvi 3 1 roll} repeat "
+			 "3 1 roll exch 3 array astore 80 printobject "
+			 "mark "
+			 "{"
+			 // moveto, flush what is below the new point first
+			 "2 array astore counttomark 1 roll "
+			 "counttomark 1 gt {counttomark 1 sub array astore //pdf2laser_state /tag get printobject} if "
+			 "//pdf2laser_state /tag 77 put "
+			 "aload pop transform round cvi exch round cvi"
+			 "}{"
+			 // lineto
+			 "transform round cvi exch round cvi "
+			 "counttomark %d ge //pdf2laser_flush if"
+			 "}{"
+			 // curveto, flush what is below the control points first
+			 "3 {transform round cvi exch round cvi 6 2 roll} repeat "
+			 "6 array astore counttomark 1 roll "
+			 "counttomark 1 gt {counttomark 1 sub array astore //pdf2laser_state /tag get printobject} if "
+			 "//pdf2laser_state /tag 76 put "
+			 "66 printobject"
+			 "}{"
+			 // closepath
+			 "//pdf2laser_flush exec [] 67 printobject"
+			 "}"
+			 "pathforall //pdf2laser_flush exec pop newpath"
+			 "}"
+			 "{"
+			 // For debugging purposes, draw the line normally
+			 "stroke"
+			 "}"
+			 "ifelse"
+			 "}bind def"
+			 "\n"
+			 "/showpage {[] 88 printobject showpage}bind def"
+			 "\n", GENERATE_VECTOR_CHUNK_NVALUES);
+		return;
+	}
+
+	fprintf
+		(prologue_fh,
+		 "{"
+		 // Display color codes
+		 "(P)=== "
+		 "currentrgbcolor "
+		 "(,)=== "
+		 "255 mul round cvi === "
+		 "(,)=== "
+		 "255 mul round cvi === "
+		 "(,)=== "
+		 "255 mul round cvi = "
+		 "{ "
+		 // moveto
+		 "transform (M)=== "
+		 "round cvi === "
+		 "(,)=== "
+		 "round cvi ="
+		 "}{"
+		 // lineto
+		 "transform(L)=== "
+		 "round cvi === "
+		 "(,)=== "
+		 "round cvi ="
+		 "}{"
+		 // curveto
+		 "3 {transform round cvi exch round cvi 6 2 roll} repeat "
+		 "6 array astore (B)=== "
+		 "{(,)=== ===} forall "
+		 "()="
+		 "}{"
+		 // closepath
+		 "(C)="
+		 "}"
+		 "pathforall newpath"
+		 "}"
+		 "{"
+		 // For debugging purposes, draw the line normally
+		 "stroke"
+		 "}"
+		 "ifelse"
+		 "}bind def"
+		 "\n"
+		 "/showpage {(X)= showpage}bind def"
+		 "\n");
+}
+
+/**
+ * Build the postscript prelude which is run ahead of the postscript file in
+ * the rendering ghostscript session. For jobs which cut it hooks stroke to
+ * report vectors on stdout, raster only jobs leave stroke alone. It then sets
+ * up the halftone screen and moves the page to its bounding box.
+ *
+ * Only the header comments of the postscript file are read, the file itself
+ * is handed to ghostscript untouched.
+ *
+ * @param print_job the print job being rendered.
+ * @param target_ps_file the postscript file which will be rendered.
+ *
+ * @return A newly allocated string of postscript, NULL on failure.
+ */
+char *generate_prologue(print_job_t *print_job, const char *target_ps_file)
+{
+	FILE *target_ps_fh = fopen(target_ps_file, "r");
+	if (target_ps_fh == NULL) {
+		perror(target_ps_file);
+		return NULL;
+	}
+
+	char *prologue = NULL;
+	size_t prologue_length = 0;
+	FILE *prologue_fh = open_memstream(&prologue, &prologue_length);
+	if (prologue_fh == NULL) {
+		perror("open_memstream failed");
+		fclose(target_ps_fh);
+		return NULL;
+	}
+
+	// Raster only jobs let stroke paint and keep stdout quiet
+	if (print_job_has_vector(print_job)) {
+		generate_prologue_vector(print_job, prologue_fh);
+	}
+
+	if (print_job->raster->mode != 'c' && print_job->raster->mode != 'g') {
+		if (print_job->raster->screen_size == 0) {
+			fprintf(prologue_fh, "{0.5 ge{1}{0}ifelse}settransfer\n");
+		}
+		else {
+			uint32_t screen_size = print_job->raster->screen_size;
+			if (print_job->raster->resolution >= 600) {
+				// adjust for overprint
+				fprintf(prologue_fh,
+				        "{dup 0 ne{%"PRId32" %"PRId32" div add}if}settransfer\n",
+				        print_job->raster->resolution / 600, screen_size);
 			}
+			fprintf(prologue_fh, "%"PRId32" 30{%s}setscreen\n", print_job->raster->resolution / screen_size,
+			        (print_job->raster->screen_size > 0) ? "pop abs 1 exch sub" :
+			        "180 mul cos exch 180 mul cos add 2 div");
 		}
-		else if (strncasecmp(line, "%%PageBoundingBox:", 18) == 0) {
+	}
+
+	char *line = NULL;
+	size_t length = 0;
+
+	// Only the leading comment block is of interest
+	while (getline(&line, &length, target_ps_fh) != -1 && *line == '%') {
+		if (strncasecmp(line, "%%PageBoundingBox:", 18) == 0) {
 
 			int32_t x_offset = 0;
 			int32_t y_offset = 0;
@@ -250,10 +384,10 @@ int generate_eps(print_job_t *print_job, char *target_ps_file, char *target_eps_
 				print_job->width = (x_upper_right - x_lower_left);
 				print_job->height = (y_upper_right - y_lower_left);
 
-				fprintf(target_eps_fh, "/setpagedevice{pop}def\n"); // use bbox
+				fprintf(prologue_fh, "/setpagedevice{pop}def\n"); // use bbox
 
 				if (x_offset || y_offset) {
-					fprintf(target_eps_fh, "%"PRId32" %"PRId32" translate\n", -x_offset, -y_offset);
+					fprintf(prologue_fh, "%"PRId32" %"PRId32" translate\n", -x_offset, -y_offset);
 				}
 			}
 		}
@@ -261,66 +395,50 @@ int generate_eps(print_job_t *print_job, char *target_ps_file, char *target_eps_
 
 	free(line);
 
-	fflush(target_eps_fh);
-
-	pdf2laser_sendfile(fileno(target_eps_fh), fileno(target_ps_fh));
-
 	fclose(target_ps_fh);
-	fclose(target_eps_fh);
+	fclose(prologue_fh);
 
-	return 0;
+	return prologue;
 }
 
 
 /**
- *
+ * Number of bytes of power levels in a raster row of the given pixel width.
  */
-int generate_raster(print_job_t *print_job, FILE *pjl_file, FILE *bitmap_file)
+int32_t generate_raster_row_bytes(print_job_t *print_job, int32_t width)
 {
-	uint8_t bitmap_header[BITMAP_HEADER_NBYTES];
-	char buf[102400];
-
-	bool invert = false;
-
-	int32_t basex = 0;
-	int32_t basey = 0;
-
-	int32_t h, d;
-
-	int32_t passes = 1;
-	if (print_job->raster->mode == 'c') {
-		passes = 7;
+	if (print_job->raster->mode == 'c' || print_job->raster->mode == 'g') {
+		/* colour/grey are byte per pixel power levels */
+		return width;
 	}
 
-	/* Read in the bitmap header. */
-	fread(bitmap_header, 1, BITMAP_HEADER_NBYTES, bitmap_file);
-
-	/* Re-load width/height from bmp as it is possible that someone used
-	 * setpagedevice or some such
-	 */
-	/* Bytes 18 - 21 are the bitmap width (little endian format). */
-	int32_t width = big_to_little_endian(bitmap_header + 18, 4);
+	/* mono */
+	return (width + 7) / 8;
+}
 
-	/* Bytes 22 - 25 are the bitmap height (little endian format). */
-	int32_t height = big_to_little_endian(bitmap_header + 22, 4);
+/**
+ * Number of passes over the page, colour mode runs one pass per primary and
+ * secondary colour.
+ */
+int32_t generate_raster_passes(print_job_t *print_job)
+{
+	return (print_job->raster->mode == 'c') ? 7 : 1;
+}
 
-	/* Bytes 10 - 13 base offset for the beginning of the bitmap data. */
-	int32_t base_offset = big_to_little_endian(bitmap_header + 10, 4);
+/**
+ * Emit the raster section header for a page of the given pixel size.
+ */
+int generate_raster_header(print_job_t *print_job, FILE *pjl_file, int32_t width, int32_t height)
+{
+	int32_t h = generate_raster_row_bytes(print_job, width);
 
-	if (print_job->raster->mode == 'c' || print_job->raster->mode == 'g') {
-		/* colour/grey are byte per pixel power levels */
-		h = width;
-		/* BMP padded to 4 bytes per scan line */
-		d = (h * 3 + 3) / 4 * 4;
-	} else {
-		/* mono */
-		h = (width + 7) / 8;
-		/* BMP padded to 4 bytes per scan line */
-		d = (h + 3) / 4 * 4;
+	if (h > GENERATE_RASTER_ROW_NBYTES) {
+		fprintf(stderr, "Too wide\n");
+		return -1;
 	}
 
 	if (print_job->debug)
-		printf("Width %"PRId32" Height %"PRId32" Bytes %"PRId32" Line %"PRId32"\n", width, height, h, d);
+		printf("Width %"PRId32" Height %"PRId32" Bytes %"PRId32"\n", width, height, h);
 
 	/* Raster Orientation */
 	fprintf(pjl_file, "\033*r0F");
@@ -347,181 +465,181 @@ int generate_raster(print_job_t *print_job, FILE *pjl_file, FILE *bitmap_file)
 
 	/* start at current position */
 	fprintf(pjl_file, "\033*r1A");
-	for (int32_t offx = 0; offx >= 0; offx -= width) {
-		for (int32_t offy = 0; offy >= 0; offy -= height) {
-			for (int32_t pass = 0; pass < passes; pass++) {
-				// raster (basic)
-				char dir = 0;
-
-				fseek(bitmap_file, base_offset, SEEK_SET);
-				for (int y = height - 1; y >= 0; y--) {
-					int l;
-
-					switch (print_job->raster->mode) {
-					case 'c': {      // colour (passes)
-						unsigned char *f = (unsigned char *) buf;
-						unsigned char *t = (unsigned char *) buf;
-						if (d > (int) sizeof (buf)) {
-							perror("Too wide");
-							return -1;
-						}
-						l = fread ((char *)buf, 1, d, bitmap_file);
-						if (l != d) {
-							fprintf(stderr, "Bad bit data from gs %"PRId32"/%"PRId32" (y=%"PRId32")\n", l, d, y);
-							return -1;
-						}
-						while (l--) {
-							// pack and pass check RGB
-							int n = 0;
-							int v = 0;
-							int p = 0;
-							int c = 0;
-							for (c = 0; c < 3; c++) {
-								if (*f > 240) {
-									p |= (1 << c);
-								} else {
-									n++;
-									v += *f;
-								}
-								f++;
-							}
-							if (n) {
-								v /= n;
-							} else {
-								p = 0;
-								v = 255;
-							}
-							if (p != pass) {
-								v = 255;
-							}
-							*t++ = 255 - v;
-						}
-					}
-						break;
-					case 'g': {      // grey level
-						/* BMP padded to 4 bytes per scan line */
-						int d = (h + 3) / 4 * 4;
-						if (d > (int) sizeof (buf)) {
-							fprintf(stderr, "Too wide\n");
-							return -1;
-						}
-						l = fread((char *)buf, 1, d, bitmap_file);
-						if (l != d) {
-							fprintf(stderr, "Bad bit data from gs %"PRId32"/%"PRId32" (y=%d)\n", l, d, y);
-							return -1;
-						}
-						for (l = 0; l < h; l++) {
-							if (invert)
-								buf[l] = (uint8_t) buf[l];
-							else
-								buf[l] = (255 - (uint8_t)buf[l]);
-						}
-					}
-						break;
-					default: {       // mono
-						static int i;
-						if (i++==0) {
-							; // printf("mono\n");
-						}
-						int d = (h + 3) / 4 * 4;  // BMP padded to 4 bytes per scan line
-						if (d > (int) sizeof (buf)) {
-							perror("Too wide");
-							return -1;
-						}
-						l = fread((char *) buf, 1, d, bitmap_file);
-						if (l != d) {
-							fprintf(stderr, "Bad bit data from gs %"PRId32"/%"PRId32" (y=%"PRId32")\n", l, d, y);
-							return -1;
-						}
-					}
-					}
-
-					if (print_job->raster->mode == 'c' || print_job->raster->mode == 'g') {
-						for (l = 0; l < h; l++) {
-							/* Raster value is multiplied by the
-							 * power scale.
-							 */
-							buf[l] = (uint8_t)buf[l] * print_job->raster->power / 255;
-						}
-					}
-
-					/* find left/right of data */
-					for (l = 0; l < h && !buf[l]; l++)
-						;
-
-					if (l < h) {
-						/* a line to print */
-						int r;
-						int n;
-						unsigned char pack[sizeof (buf) * 5 / 4 + 1];
-						for (r = h - 1; r > l && !buf[r]; r--)
-							;
-
-						r++;
-						fprintf(pjl_file, "\033*p%"PRId32"Y", basey + offy + y);
-						fprintf(pjl_file, "\033*p%"PRId32"X", basex + offx +
-						        ((print_job->raster->mode == 'c' || print_job->raster->mode == 'g') ? l : l * 8));
-						if (dir) {
-							fprintf(pjl_file, "\033*b%"PRId32"A", -(r - l));
-							// reverse bytes!
-							for (n = 0; n < (r - l) / 2; n++){
-								unsigned char t = buf[l + n];
-								buf[l + n] = buf[r - n - 1];
-								buf[r - n - 1] = t;
-							}
-						} else {
-							fprintf(pjl_file, "\033*b%"PRId32"A", (r - l));
-						}
-						dir = 1 - dir;
-						// pack
-						n = 0;
-						while (l < r) {
-							int p;
-							for (p = l; p < r && p < l + 128 && buf[p] == buf[l]; p++) {
-								;
-							}
-							if (p - l >= 2) {
-								// run length
-								pack[n++] = 257 - (p - l);
-								pack[n++] = buf[l];
-								l = p;
-							} else {
-								for (p = l;
-								     p < r && p < l + 127 &&
-									     (p + 1 == r || buf[p] !=
-									      buf[p + 1]);
-								     p++) {
-									;
-								}
-
-								pack[n++] = p - l - 1;
-								while (l < p) {
-									pack[n++] = buf[l++];
-								}
-							}
-						}
-						fprintf(pjl_file, "\033*b%"PRId32"W", (n + 7) / 8 * 8);
-						r = 0;
-						while (r < n)
-							fputc(pack[r++], pjl_file);
-						while (r & 7) {
-							r++;
-							fputc(0x80, pjl_file);
-						}
-					}
+
+	return 0;
+}
+
+/**
+ * Encode a single row of the page. Rows are expected from the bottom of the
+ * page up, and dir has to be reset to 0 at the start of every pass.
+ *
+ * @param row the pixels of the row, in the display sink's layout.
+ * @param y the row's distance from the top of the page.
+ * @param pass the current pass, only meaningful in colour mode.
+ * @param dir the head direction, toggled for every printed line.
+ */
+int generate_raster_row(print_job_t *print_job, FILE *pjl_file, const uint8_t *row, int32_t width, int32_t y, int32_t pass, char *dir)
+{
+	char buf[GENERATE_RASTER_ROW_NBYTES];
+
+	bool invert = false;
+
+	int32_t h = generate_raster_row_bytes(print_job, width);
+	int l;
+
+	switch (print_job->raster->mode) {
+	case 'c': {      // colour (passes)
+		const unsigned char *f = row;
+		unsigned char *t = (unsigned char *) buf;
+		for (l = 0; l < h; l++) {
+			// pack and pass check RGB
+			int n = 0;
+			int v = 0;
+			int p = 0;
+			int c = 0;
+			for (c = 0; c < 3; c++) {
+				if (*f > 240) {
+					p |= (1 << c);
+				} else {
+					n++;
+					v += *f;
+				}
+				f++;
+			}
+			if (n) {
+				v /= n;
+			} else {
+				p = 0;
+				v = 255;
+			}
+			if (p != pass) {
+				v = 255;
+			}
+			*t++ = 255 - v;
+		}
+	}
+		break;
+	case 'g': {      // grey level
+		for (l = 0; l < h; l++) {
+			if (invert)
+				buf[l] = row[l];
+			else
+				buf[l] = (255 - row[l]);
+		}
+	}
+		break;
+	default: {       // mono
+		memcpy(buf, row, h);
+	}
+	}
+
+	if (print_job->raster->mode == 'c' || print_job->raster->mode == 'g') {
+		for (l = 0; l < h; l++) {
+			/* Raster value is multiplied by the
+			 * power scale.
+			 */
+			buf[l] = (uint8_t)buf[l] * print_job->raster->power / 255;
+		}
+	}
+
+	/* find left/right of data */
+	for (l = 0; l < h && !buf[l]; l++)
+		;
+
+	if (l < h) {
+		/* a line to print */
+		int r;
+		int n;
+		unsigned char pack[sizeof (buf) * 5 / 4 + 1];
+		for (r = h - 1; r > l && !buf[r]; r--)
+			;
+
+		r++;
+		fprintf(pjl_file, "\033*p%"PRId32"Y", y);
+		fprintf(pjl_file, "\033*p%"PRId32"X",
+		        ((print_job->raster->mode == 'c' || print_job->raster->mode == 'g') ? l : l * 8));
+		if (*dir) {
+			fprintf(pjl_file, "\033*b%"PRId32"A", -(r - l));
+			// reverse bytes!
+			for (n = 0; n < (r - l) / 2; n++){
+				unsigned char t = buf[l + n];
+				buf[l + n] = buf[r - n - 1];
+				buf[r - n - 1] = t;
+			}
+		} else {
+			fprintf(pjl_file, "\033*b%"PRId32"A", (r - l));
+		}
+		*dir = 1 - *dir;
+		// pack
+		n = 0;
+		while (l < r) {
+			int p;
+			for (p = l; p < r && p < l + 128 && buf[p] == buf[l]; p++) {
+				;
+			}
+			if (p - l >= 2) {
+				// run length
+				pack[n++] = 257 - (p - l);
+				pack[n++] = buf[l];
+				l = p;
+			} else {
+				for (p = l;
+				     p < r && p < l + 127 &&
+					     (p + 1 == r || buf[p] !=
+					      buf[p + 1]);
+				     p++) {
+					;
+				}
+
+				pack[n++] = p - l - 1;
+				while (l < p) {
+					pack[n++] = buf[l++];
 				}
 			}
 		}
+		fprintf(pjl_file, "\033*b%"PRId32"W", (n + 7) / 8 * 8);
+		r = 0;
+		while (r < n)
+			fputc(pack[r++], pjl_file);
+		while (r & 7) {
+			r++;
+			fputc(0x80, pjl_file);
+		}
 	}
 
+	return 0;
+}
+
+int generate_raster_footer(__attribute__ ((unused)) print_job_t *print_job, FILE *pjl_file)
+{
 	fprintf(pjl_file, "\033*rC");       // end raster
 	fputc(26, pjl_file);      // some end of file markers
 	fputc(4, pjl_file);
-	//}
 
 	return 0;
 }
 
+/**
+ * Encode a fully rendered page.
+ */
+int generate_raster(print_job_t *print_job, FILE *pjl_file, bitmap_t *bitmap)
+{
+	if (generate_raster_header(print_job, pjl_file, bitmap->width, bitmap->height))
+		return -1;
+
+	int32_t passes = generate_raster_passes(print_job);
+	for (int32_t pass = 0; pass < passes; pass++) {
+		// raster (basic)
+		char dir = 0;
+
+		for (int32_t y = bitmap->height - 1; y >= 0; y--) {
+			generate_raster_row(print_job, pjl_file, bitmap_row(bitmap, y), bitmap->width, y, pass, &dir);
+		}
+	}
+
+	return generate_raster_footer(print_job, pjl_file);
+}
+
 
 /**
  * Generate a list of vectors.
@@ -537,141 +655,414 @@ int generate_raster(print_job_t *print_job, FILE *pjl_file, FILE *bitmap_file)
  * then passed into the topological sort routine.
  *
  * Exact duplictes will be deleted to try to avoid double hits..
+ *
+ * The HPGL for the list is rendered into hpgl_buffer, after what it holds,
+ * so that a pass repeated several times is only formatted once.
+ *
+ * @return The buffer, NULL if it could not grow.
  */
-int vectors_parse(print_job_t *print_job, FILE * const vector_file)
+static hpgl_buffer_t *output_vector(vector_list_t *list, hpgl_buffer_t *hpgl_buffer)
 {
-	vector_list_t *current_list = NULL;
-
-	int32_t vector_count = 0;
+	point_t current = { 0, 0 };
+	bool drawing = false;
+	for (size_t index = 0; index < list->length; index++) {
+		vector_t vector;
+		vector_list_get(list, index, &vector);
 
-	int32_t x_start = 0;
-	int32_t y_start = 0;
-	int32_t x_current = 0;
-	int32_t y_current = 0;
-
-	char *line = NULL;
-	size_t length = 0;
-	ssize_t length_read = 0;
-
-	while ((length_read = getline(&line, &length, vector_file)) != -1) {
-		switch (*line) {
-		case 'P': {
-			// Note: Colours are stored as blue, green, red in the vector file
-			int32_t red, green, blue;
-			sscanf(line, "P,%d,%d,%d", &blue, &green, &red);
-			vector_list_config_t *config = print_job_find_vector_list_config_by_rgb(print_job, red, green, blue);
-			if (config == NULL)
-				config = print_job_clone_last_vector_list_config(print_job, red, green, blue);
-			current_list = config->vector_list;
-			break;
+		if (drawing && point_equal(&vector.start, &current)) {
+			// This is the continuation of a line, so just add additional
+			// points
+			if (hpgl_buffer_add_pair(hpgl_buffer, ",", vector.end.y, vector.end.x) == NULL)
+				return NULL;
 		}
-		case 'M': {
-			// Start of new line. Implicitly sets current laser position.
-			sscanf(line, "M%d,%d", &x_start, &y_start);
-			x_current = x_start;
-			y_current = y_start;
-			break;
+		else {
+			// Stop the laser; we need to transit and then start the laser as
+			// we go to the next point.  Note initial ";"
+			if (hpgl_buffer_add_pair(hpgl_buffer, ";PU", vector.start.y, vector.start.x) == NULL ||
+			    hpgl_buffer_add_pair(hpgl_buffer, ";PD", vector.end.y, vector.end.x) == NULL)
+				return NULL;
 		}
-		case 'L': {
-			int32_t x_next, y_next;
-			sscanf(line, "L%d,%d", &x_next, &y_next);
-			vector_t *vector = vector_create(x_current, y_current, x_next, y_next);
-			if (print_job->vector_optimize &&
-			    vector_list_contains(current_list, vector) >= 0) {
-				free(vector);
-			}
-			else {
-				vector_list_append(current_list, vector);
-				vector_count += 1;
-			}
-			x_current = x_next;
-			y_current = y_next;
+
+		// Changing power on the fly is not supported for now
+		// \todo: Check v->power and adjust ZS, XR, etc
+
+		// Move to the next vector, updating our current point
+		current = vector.end;
+		drawing = true;
+	}
+
+	// Stop the laser (note initial ";")
+	return hpgl_buffer_append(hpgl_buffer, ";PU;", 4);
+}
+
+/*
+ * One layer of the vector pass, as handed to the optimizer pool. What its
+ * stages report is kept so reports can be printed in cut order.
+ */
+struct generate_vector_layer {
+	vector_list_config_t *config;
+	FILE *report;
+	char *report_text;
+	size_t report_length;
+	int rc;
+
+	// Paths of the layer between stages, chained then ordered
+	path_list_t *paths;
+
+	// Where the head is when the layer starts
+	point_t origin;
+
+	// Whether the next layer starts where this one ends
+	bool keep_last;
+};
+
+struct generate_vector_pool {
+	print_job_t *print_job;
+	struct generate_vector_layer *layers;
+	size_t count;
+	size_t next;
+	pthread_mutex_t lock;
+
+	// Stage run on every layer
+	int (*stage)(print_job_t *print_job, struct generate_vector_layer *layer);
+};
+
+/*
+ * Replace the vectors of a layer with those a stage made of them.
+ */
+static int generate_vector_replace(vector_list_config_t *vector_list_config, vector_list_t *vector_list,
+                                   const char *failure)
+{
+	if (vector_list == NULL) {
+		perror(failure);
+		return -1;
+	}
+
+	vector_list_destroy(vector_list_config->vector_list);
+	vector_list_config->vector_list = vector_list;
+
+	return 0;
+}
+
+/*
+ * Replace the paths of a layer with those a stage made of them.
+ */
+static int generate_vector_replace_paths(struct generate_vector_layer *layer, path_list_t *paths, const char *failure)
+{
+	if (paths == NULL) {
+		perror(failure);
+		return -1;
+	}
+
+	if (layer->paths != paths)
+		path_list_destroy(layer->paths);
+	layer->paths = paths;
+
+	return 0;
+}
+
+/*
+ * The stages of one layer which do not depend on where the head starts:
+ * simplifying and, when optimizing, trimming overlaps and chaining vectors
+ * sharing endpoints into polylines.
+ */
+static int generate_vector_prepare(print_job_t *print_job, struct generate_vector_layer *layer)
+{
+	vector_list_config_t *vector_list_config = layer->config;
+
+	if (vector_list_config->simplify >= 0) {
+		vector_list_t *vector_list = vector_list_simplify(vector_list_config->vector_list, vector_list_config->simplify,
+		                                                  layer->report);
+		if (generate_vector_replace(vector_list_config, vector_list, "Failed to simplify vectors"))
+			return -1;
+	}
+
+	if (print_job->vector_optimize) {
+		vector_list_t *vector_list = vector_list_trim_overlaps(vector_list_config->vector_list, layer->report);
+		if (generate_vector_replace(vector_list_config, vector_list, "Failed to trim vectors"))
+			return -1;
+
+		path_list_t *paths = path_list_chain(vector_list_config->vector_list);
+		if (generate_vector_replace_paths(layer, paths, "Failed to chain vectors"))
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * The stages of one layer left once its start is known: improving the
+ * order, which keeps the end the next layer starts from, and flattening the
+ * paths back into the layer's vectors.
+ */
+static int generate_vector_finish(print_job_t *print_job, struct generate_vector_layer *layer)
+{
+	if (print_job->vector_improve > 0 || print_job->vector_sweeps > 0) {
+		path_list_t *paths = path_list_improve(layer->paths, print_job->vector_sweeps, print_job->vector_improve,
+		                                       print_job->kinematics, &layer->origin, layer->keep_last, layer->report);
+		if (generate_vector_replace_paths(layer, paths, "Failed to improve vectors"))
+			return -1;
+
+		paths = path_list_rotate(layer->paths, print_job->kinematics, &layer->origin, layer->keep_last);
+		if (generate_vector_replace_paths(layer, paths, "Failed to rotate vectors"))
+			return -1;
+	}
+
+	vector_list_t *vector_list = path_list_to_vector_list(layer->paths);
+	if (generate_vector_replace(layer->config, vector_list, "Failed to optimize vectors"))
+		return -1;
+
+	vector_list_stats(layer->config->vector_list, &layer->origin, layer->report);
+
+	return 0;
+}
+
+/*
+ * Worker of the optimizer pool, taking the next layer until none are left.
+ */
+static void *generate_vector_work(void *arg)
+{
+	struct generate_vector_pool *pool = arg;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		size_t index = pool->next;
+		if (index < pool->count)
+			pool->next += 1;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (index >= pool->count)
+			return NULL;
+
+		struct generate_vector_layer *layer = &pool->layers[index];
+		layer->rc = pool->stage(pool->print_job, layer);
+	}
+}
+
+/*
+ * Run a stage over every layer, on as many threads as the job asks for, or
+ * one per core, up to one per layer, the calling thread being one of them.
+ *
+ * @return 0 on success, -1 if any layer failed.
+ */
+static int generate_vector_run_pool(print_job_t *print_job, struct generate_vector_layer *layers, size_t count,
+                                    int (*stage)(print_job_t *print_job, struct generate_vector_layer *layer))
+{
+	struct generate_vector_pool pool = { print_job, layers, count, 0, PTHREAD_MUTEX_INITIALIZER, stage };
+
+	long cores = (print_job->threads > 0) ? (long)print_job->threads : sysconf(_SC_NPROCESSORS_ONLN);
+	size_t thread_count = (cores > 1) ? (size_t)cores : 1;
+	if (thread_count > count)
+		thread_count = count;
+
+	// Should threads fail to start, the calling thread does the rest
+	pthread_t *threads = (thread_count > 1) ? calloc(thread_count - 1, sizeof(pthread_t)) : NULL;
+	size_t started = 0;
+	while (threads != NULL && started < thread_count - 1) {
+		if (pthread_create(&threads[started], NULL, generate_vector_work, &pool)) {
+			perror("pthread_create failed");
 			break;
 		}
-		case 'C': {
-			// Closing statment from current point to starting point.
-			vector_t *vector = vector_create(x_current, y_current, x_start, y_start);
-			if (print_job->vector_optimize &&
-			    vector_list_contains(current_list, vector) >= 0) {
-				free(vector);
-			}
-			else {
-				vector_list_append(current_list, vector);
+		started += 1;
+	}
+
+	generate_vector_work(&pool);
+
+	for (size_t thread = 0; thread < started; thread += 1)
+		pthread_join(threads[thread], NULL);
+	free(threads);
+
+	int rc = 0;
+	for (size_t index = 0; index < count; index += 1) {
+		if (layers[index].rc)
+			rc = -1;
+	}
+
+	return rc;
+}
+
+/**
+ * Order the cuts of every layer greedily, each starting where the head is
+ * left by the one before. Layers made by fallthrough were not placed by the
+ * user, so a run of them is cut quickest to reach first, by the machine model,
+ * otherwise layers keep their order.
+ *
+ * @param order the layers in cut order, starting out in config order.
+ *
+ * @return 0 on success, -1 if any layer failed.
+ */
+static int generate_vector_order(print_job_t *print_job, struct generate_vector_layer *layers, size_t *order,
+                                 size_t count)
+{
+	point_t origin = { 0, 0 };
+
+	for (size_t placed = 0; placed < count; placed += 1) {
+		size_t run_end = placed;
+		while (run_end < count && layers[order[run_end]].config->fallthrough)
+			run_end += 1;
+
+		size_t best = placed;
+		double best_time = INFINITY;
+		for (size_t index = placed; index < run_end; index += 1) {
+			double time = path_list_entry_time(layers[order[index]].paths, print_job->kinematics, &origin);
+			if (time < best_time) {
+				best_time = time;
+				best = index;
 			}
-			x_current = x_start;
-			y_current = y_start;
-			break;
 		}
-		case 'X':
-			goto vector_parse_complete;
-		default:
-			fprintf(stderr, "Unknown command '%c'", *line);
+
+		// Layers stay where they are, their reports write into them
+		size_t swap = order[best];
+		order[best] = order[placed];
+		order[placed] = swap;
+
+		struct generate_vector_layer *layer = &layers[order[placed]];
+		layer->origin = origin;
+		layer->keep_last = placed + 1 < count;
+
+		path_list_t *paths = (print_job->vector_parts == VECTOR_LIST_PARTS_NONE) ?
+			path_list_optimize(layer->paths, print_job->kinematics, &origin) :
+			path_list_optimize_parts(layer->paths, print_job->kinematics,
+			                         print_job->vector_parts == VECTOR_LIST_PARTS_INNER, &origin);
+		if (generate_vector_replace_paths(layer, paths, "Failed to order vectors"))
 			return -1;
+
+		paths = path_list_rotate(layer->paths, print_job->kinematics, &origin, false);
+		if (generate_vector_replace_paths(layer, paths, "Failed to rotate vectors"))
+			return -1;
+
+		if (paths->point_count > 0) {
+			origin.x = paths->x[paths->point_count - 1];
+			origin.y = paths->y[paths->point_count - 1];
 		}
 	}
 
- vector_parse_complete:
+	// Cut the layers in the order chosen
+	vector_list_config_t **link = &print_job->configs;
+	for (size_t index = 0; index < count; index += 1) {
+		vector_list_config_t *vector_list_config = layers[order[index]].config;
+		vector_list_config->index = (uint32_t)index;
+		*link = vector_list_config;
+		link = &vector_list_config->next;
+	}
+	*link = NULL;
 
 	return 0;
 }
 
-static void output_vector(vector_list_t *list, FILE * const pjl_file)
+/**
+ * Prepare every layer of the vector pass. What only looks at the layer
+ * itself, simplifying, trimming and chaining, runs on a pool of threads.
+ * Ordering then goes layer by layer, as each starts where the one before
+ * ended, and improvement runs on the pool again. Every stage gives the same
+ * result whatever thread runs it, unless a time budget cuts improvement short,
+ * as how far it gets then depends on the load. Reports are printed in cut
+ * order once every layer is done.
+ *
+ * @return 0 on success, -1 if any layer failed.
+ */
+static int generate_vector_prepare_all(print_job_t *print_job)
 {
-	int32_t current_x = 0;
-	int32_t current_y = 0;
-	vector_t *vector = list->head;
-	while (vector) {
-		if (point_compare(vector->start, &(point_t){ current_x, current_y })) {
-			// This is the continuation of a line, so just add additional
-			// points
-			fprintf(pjl_file, ",%"PRId32",%"PRId32"", vector->end->y, vector->end->x);
-		}
-		else {
-			// Stop the laser; we need to transit and then start the laser as
-			// we go to the next point.  Note initial ";"
-			fprintf(pjl_file, ";PU%"PRId32",%"PRId32";PD%"PRId32",%"PRId32"", vector->start->y, vector->start->x, vector->end->y, vector->end->x);
-		}
+	size_t count = 0;
+	for (vector_list_config_t *vector_list_config = print_job->configs;
+	     vector_list_config != NULL;
+	     vector_list_config = vector_list_config->next) {
+		count += 1;
+	}
 
-		// Changing power on the fly is not supported for now
-		// \todo: Check v->power and adjust ZS, XR, etc
+	if (count == 0)
+		return 0;
 
-		// Move to the next vector, updating our current point
-		current_x = vector->end->x;
-		current_y = vector->end->y;
-		vector = vector->next;
+	struct generate_vector_layer *layers = calloc(count, sizeof(struct generate_vector_layer));
+	size_t *order = calloc(count, sizeof(size_t));
+	if (layers == NULL || order == NULL) {
+		perror("calloc failed");
+		free(layers);
+		free(order);
+		return -1;
 	}
 
-	// Stop the laser (note initial ";")
-	fprintf(pjl_file, ";PU;");
+	int rc = 0;
+	size_t index = 0;
+	for (vector_list_config_t *vector_list_config = print_job->configs;
+	     vector_list_config != NULL;
+	     vector_list_config = vector_list_config->next, index += 1) {
+		order[index] = index;
+		layers[index].config = vector_list_config;
+		layers[index].report = open_memstream(&layers[index].report_text, &layers[index].report_length);
+		if (layers[index].report == NULL) {
+			perror("open_memstream failed");
+			rc = -1;
+		}
+	}
+
+	if (rc == 0)
+		rc = generate_vector_run_pool(print_job, layers, count, generate_vector_prepare);
+
+	if (rc == 0 && print_job->vector_optimize)
+		rc = generate_vector_order(print_job, layers, order, count);
+
+	if (rc == 0 && print_job->vector_optimize)
+		rc = generate_vector_run_pool(print_job, layers, count, generate_vector_finish);
+
+	for (index = 0; index < count; index += 1) {
+		struct generate_vector_layer *layer = &layers[order[index]];
+		path_list_destroy(layer->paths);
+		if (layer->report == NULL)
+			continue;
+		fclose(layer->report);
+		fwrite(layer->report_text, 1, layer->report_length, stdout);
+		free(layer->report_text);
+	}
+
+	free(layers);
+	free(order);
+
+	return rc;
 }
 
-int generate_vector(print_job_t *print_job, FILE * const pjl_file, FILE * const vector_file)
+int generate_vector(print_job_t *print_job, FILE * const pjl_file)
 {
-	// this mutates vectors parser in print_job
-	vectors_parse(print_job, vector_file);
-
 	fprintf(pjl_file, "IN;");
 
+	// Vectors are traced in device units at the raster resolution
+	print_job->kinematics->resolution = print_job->raster->resolution;
+
+	if (generate_vector_prepare_all(print_job))
+		return -1;
+
+	hpgl_buffer_t *hpgl_buffer = hpgl_buffer_create();
+	if (hpgl_buffer == NULL) {
+		perror("Failed to allocate HPGL buffer");
+		return -1;
+	}
+
 	for (vector_list_config_t *vector_list_config = print_job->configs;
 	     vector_list_config != NULL;
 	     vector_list_config = vector_list_config->next) {
 
 		fprintf(pjl_file, "XR%04"PRId32";", vector_list_config->frequency);
-
-		if (print_job->vector_optimize) {
-			vector_list_t *vector_list = vector_list_config->vector_list;
-			vector_list_config->vector_list = vector_list_optimize(vector_list);
-			free(vector_list);
-		}
-
 		fprintf(pjl_file, "YP%03"PRId32";", vector_list_config->power);
 		fprintf(pjl_file, "ZS%03"PRId32"", vector_list_config->speed); // NB. no ";"
 
+		if (output_vector(vector_list_config->vector_list, hpgl_buffer_clear(hpgl_buffer)) == NULL) {
+			perror("Failed to render vectors");
+			hpgl_buffer_destroy(hpgl_buffer);
+			return -1;
+		}
+
+		// Every pass is the same, replay the rendered one
 		for (int pass = 0; pass < vector_list_config->multipass; pass++) {
-			output_vector(vector_list_config->vector_list, pjl_file);
+			if (!hpgl_buffer_write(hpgl_buffer, pjl_file)) {
+				perror("Failed to write vectors");
+				hpgl_buffer_destroy(hpgl_buffer);
+				return -1;
+			}
 		}
 	}
 
+	hpgl_buffer_destroy(hpgl_buffer);
+
 	fprintf(pjl_file, "\033%%0B");   // end HLGL
 	fprintf(pjl_file, "\033%%1BPU"); // start HLGL, pen up?
 
@@ -682,11 +1073,8 @@ int generate_vector(print_job_t *print_job, FILE * const pjl_file, FILE * const
 /**
  *
  */
-//print_job, target_bmp, target_vector, target_pjl)) {
-int generate_pjl(print_job_t *print_job, char *bmp_target, char *vector_target, char *pjl_target)
+int generate_pjl(print_job_t *print_job, char *raster_target, char *pjl_target)
 {
-	FILE *bmp_target_fh = fopen(bmp_target, "r");
-	FILE *vector_target_fh = fopen(vector_target, "r");
 	FILE *pjl_target_fh = fopen(pjl_target, "w");
 
 	/* Print the printer job language header. */
@@ -716,13 +1104,19 @@ int generate_pjl(print_job_t *print_job, char *bmp_target, char *vector_target,
 	/* If raster power is enabled and raster mode is not 'n' then add that
 	 * information to the print job.
 	 */
-	if (print_job->mode == PRINT_JOB_MODE_RASTER ||
-	    print_job->mode == PRINT_JOB_MODE_COMBINED) {
+	if (print_job_has_raster(print_job)) {
 		/* FIXME unknown purpose. */
 		fprintf(pjl_target_fh, "\033&y0C");
 
-		/* We're going to perform a raster print. */
-		generate_raster(print_job, pjl_target_fh, bmp_target_fh);
+		/* We're going to perform a raster print, encoded while rendering. */
+		FILE *raster_target_fh = fopen(raster_target, "r");
+		if (raster_target_fh == NULL) {
+			perror(raster_target);
+			return -1;
+		}
+		fflush(pjl_target_fh);
+		pdf2laser_sendfile(fileno(pjl_target_fh), fileno(raster_target_fh));
+		fclose(raster_target_fh);
 	}
 
 	/* If vector power is > 0 then add vector information to the print job. */
@@ -735,16 +1129,18 @@ int generate_pjl(print_job_t *print_job, char *bmp_target, char *vector_target,
 	fprintf(pjl_target_fh, "\033*rC");
 	fprintf(pjl_target_fh, "\033%%1B");
 
-	if (print_job->mode == PRINT_JOB_MODE_VECTOR ||
-	    print_job->mode == PRINT_JOB_MODE_COMBINED) {
+	if (print_job_has_vector(print_job)) {
 
 		if (print_job->configs == NULL) {
 			fprintf(stderr, "No vector settings provided, cannot generate vector.\n");
 			return -1;
 		}
 
-		/* We're going to perform a vector print. */
-		generate_vector(print_job, pjl_target_fh, vector_target_fh);
+		/* We're going to perform a vector print, the vectors were parsed
+		 * while ghostscript ran.
+		 */
+		if (generate_vector(print_job, pjl_target_fh))
+			return -1;
 	}
 
 	/* Footer for printer job language. */
@@ -763,8 +1159,6 @@ int generate_pjl(print_job_t *print_job, char *bmp_target, char *vector_target,
 	// for(int i = 0; i < 4096; i++)
 	//	fputc(0, pjl_target_fh);
 
-	fclose(bmp_target_fh);
-	fclose(vector_target_fh);
 	fclose(pjl_target_fh);
 
 	return 0;
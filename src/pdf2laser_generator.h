@@ -2,7 +2,9 @@
 #define __PDF2LASER_GENERATOR_H__ 1
 
 #include <stdbool.h>         // for bool
+#include <stdint.h>          // for int32_t, uint8_t
 #include <stdio.h>           // for FILE
+#include "type_bitmap.h"     // for bitmap_t
 #include "type_print_job.h"  // for print_job_t
 
 #ifdef __cplusplus
@@ -12,18 +14,28 @@ extern "C" {
 }
 #endif
 
-//Number of bytes in the bitmap header.
-#define BITMAP_HEADER_NBYTES (54)
+// Largest supported raster row, in bytes of power levels.
+#define GENERATE_RASTER_ROW_NBYTES (102400)
+
+// Most coordinates the compact vector protocol batches into one record.
+#define GENERATE_VECTOR_CHUNK_NVALUES (1024)
 
 // how many different vector power level groups
 #define VECTOR_PASSES 3
 
-int generate_pdf(const char * source_pdf, const char *target_pdf);
+char *generate_pdf_path(const char *source_pdf);
+int generate_pdf(const char *source_pdf, const char *target_pdf);
 int generate_ps(const char *target_pdf, const char *target_ps);
-int generate_eps(print_job_t *print_job, char *target_ps_file, char *target_eps_file);
-int generate_raster(print_job_t *print_job, FILE *pjl_file, FILE *bitmap_file);
-int generate_vector(print_job_t *print_job, FILE *pjl_file, FILE *vector_file);
-int generate_pjl(print_job_t *print_job, char *bmp_target, char *vector_target, char *pjl_target);
+bool source_is_postscript(const char *source);
+char *generate_prologue(print_job_t *print_job, const char *target_ps_file);
+int32_t generate_raster_row_bytes(print_job_t *print_job, int32_t width);
+int32_t generate_raster_passes(print_job_t *print_job);
+int generate_raster_header(print_job_t *print_job, FILE *pjl_file, int32_t width, int32_t height);
+int generate_raster_row(print_job_t *print_job, FILE *pjl_file, const uint8_t *row, int32_t width, int32_t y, int32_t pass, char *dir);
+int generate_raster_footer(print_job_t *print_job, FILE *pjl_file);
+int generate_raster(print_job_t *print_job, FILE *pjl_file, bitmap_t *bitmap);
+int generate_vector(print_job_t *print_job, FILE *pjl_file);
+int generate_pjl(print_job_t *print_job, char *raster_target, char *pjl_target);
 
 #ifdef __cplusplus
 };
@@ -1,14 +1,22 @@
+#ifdef __linux
+#define _GNU_SOURCE
+#endif
+
 #include "pdf2laser_util.h"
-#include <errno.h>         // for errno, EAGAIN, EINTR
+#include <errno.h>         // for errno, EAGAIN, EINTR, ENOSYS
 #include <stdarg.h>        // for va_end, va_start, va_list
 #include <stddef.h>        // for NULL, size_t
 #include <stdio.h>         // for perror, vsnprintf, SEEK_SET
 #include <stdlib.h>        // for calloc, free
+#include "config.h"        // for HAVE_MEMFD_CREATE
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>      // for memfd_create
+#endif
 #ifdef __linux
 #include <sys/sendfile.h>  // for sendfile
 #endif
 #include <sys/stat.h>      // for fstat, stat
-#include <unistd.h>        // for lseek, ssize_t
+#include <unistd.h>        // for lseek, read, write, ssize_t
 
 
 int pdf2laser_sendfile(int out_fd, int in_fd)
@@ -46,6 +54,39 @@ int pdf2laser_sendfile(int out_fd, int in_fd)
 	return 0;
 }
 
+/**
+ * Copy everything from in_fd to out_fd until end of file. Unlike
+ * pdf2laser_sendfile this does not need to know the size of the input ahead
+ * of time, so it works on pipes and sockets.
+ */
+int pdf2laser_copyfd(int out_fd, int in_fd)
+{
+	char buffer[102400];
+	ssize_t rc;
+
+	while ((rc = read(in_fd, buffer, sizeof(buffer))) != 0) {
+		if (rc < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			perror("read failed");
+			return errno;
+		}
+
+		for (ssize_t written = 0, ws; written < rc; written += ws) {
+			if ((ws = write(out_fd, buffer + written, rc - written)) < 0) {
+				if (errno == EINTR || errno == EAGAIN) {
+					ws = 0;
+					continue;
+				}
+				perror("write failed");
+				return errno;
+			}
+		}
+	}
+
+	return 0;
+}
+
 char *pdf2laser_format_string(char *template, ...)
 {
 	va_list ap;
@@ -76,3 +117,34 @@ char *pdf2laser_format_string(char *template, ...)
 
 	return s;
 }
+
+/**
+ * Create an anonymous, memory backed file. The file never touches the
+ * filesystem and is released when the last descriptor to it is closed.
+ *
+ * @param name the name of the file, only used for debugging purposes.
+ *
+ * @return A file descriptor for the new file, -1 if it could not be created.
+ */
+int pdf2laser_memfd_create(const char *name)
+{
+#ifdef HAVE_MEMFD_CREATE
+	int fd = memfd_create(name, 0);
+	if (fd < 0)
+		perror("memfd_create failed");
+	return fd;
+#else
+	(void)name;
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/**
+ * Build a path which re-opens the given file descriptor, allowing anonymous
+ * files to be handed to ghostscript or fopen like any other file.
+ */
+char *pdf2laser_fd_path(int fd)
+{
+	return pdf2laser_format_string("/dev/fd/%d", fd);
+}
@@ -12,7 +12,10 @@ extern "C" {
 #endif
 
 int pdf2laser_sendfile(int out_fd, int in_fd);
+int pdf2laser_copyfd(int out_fd, int in_fd);
 char *pdf2laser_format_string(char *template, ...);
+int pdf2laser_memfd_create(const char *name);
+char *pdf2laser_fd_path(int fd);
 
 #ifdef __cplusplus
 };
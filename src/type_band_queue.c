@@ -0,0 +1,128 @@
+#include "type_band_queue.h"
+#include <pthread.h>  // for pthread_cond_signal, pthread_cond_wait, pthread_mutex_lock, pthread_mutex_unlock, pthread_cond_broadcast, pthread_cond_destroy, pthread_cond_init, pthread_mutex_destroy, pthread_mutex_init
+#include <stdbool.h>  // for false, true
+#include <stddef.h>   // for size_t, NULL
+#include <stdint.h>   // for int32_t, uint8_t
+#include <stdlib.h>   // for calloc, free
+
+band_queue_t *band_queue_create(size_t capacity, size_t band_size)
+{
+	band_queue_t *band_queue = calloc(1, sizeof(band_queue_t));
+	if (band_queue == NULL)
+		return NULL;
+
+	band_queue->data = calloc(capacity, band_size);
+	band_queue->band_y = calloc(capacity, sizeof(int32_t));
+	band_queue->band_rows = calloc(capacity, sizeof(int32_t));
+	if (band_queue->data == NULL || band_queue->band_y == NULL || band_queue->band_rows == NULL) {
+		free(band_queue->data);
+		free(band_queue->band_y);
+		free(band_queue->band_rows);
+		free(band_queue);
+		return NULL;
+	}
+
+	band_queue->band_size = band_size;
+	band_queue->capacity = capacity;
+	band_queue->head = 0;
+	band_queue->tail = 0;
+	band_queue->count = 0;
+	band_queue->closed = false;
+
+	pthread_mutex_init(&band_queue->mutex, NULL);
+	pthread_cond_init(&band_queue->not_full, NULL);
+	pthread_cond_init(&band_queue->not_empty, NULL);
+
+	return band_queue;
+}
+
+band_queue_t *band_queue_destroy(band_queue_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	pthread_cond_destroy(&self->not_empty);
+	pthread_cond_destroy(&self->not_full);
+	pthread_mutex_destroy(&self->mutex);
+
+	free(self->band_rows);
+	free(self->band_y);
+	free(self->data);
+	free(self);
+
+	return NULL;
+}
+
+/**
+ * Wait for a free slot and return its memory. The slot stays owned by the
+ * producer until it is handed on with band_queue_publish.
+ */
+uint8_t *band_queue_acquire(band_queue_t *self)
+{
+	pthread_mutex_lock(&self->mutex);
+	while (self->count == self->capacity && !self->closed)
+		pthread_cond_wait(&self->not_full, &self->mutex);
+
+	uint8_t *band = self->closed ? NULL : self->data + self->head * self->band_size;
+	pthread_mutex_unlock(&self->mutex);
+
+	return band;
+}
+
+void band_queue_publish(band_queue_t *self, int32_t y, int32_t rows)
+{
+	pthread_mutex_lock(&self->mutex);
+
+	self->band_y[self->head] = y;
+	self->band_rows[self->head] = rows;
+	self->head = (self->head + 1) % self->capacity;
+	self->count += 1;
+
+	pthread_cond_signal(&self->not_empty);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+/**
+ * Mark the end of the stream, the consumer drains whatever was published.
+ */
+void band_queue_close(band_queue_t *self)
+{
+	pthread_mutex_lock(&self->mutex);
+	self->closed = true;
+	pthread_cond_broadcast(&self->not_empty);
+	pthread_cond_broadcast(&self->not_full);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+/**
+ * Wait for the oldest published band.
+ *
+ * @return The band's memory, or NULL once the queue is closed and drained.
+ */
+uint8_t *band_queue_peek(band_queue_t *self, int32_t *y, int32_t *rows)
+{
+	pthread_mutex_lock(&self->mutex);
+	while (self->count == 0 && !self->closed)
+		pthread_cond_wait(&self->not_empty, &self->mutex);
+
+	uint8_t *band = NULL;
+	if (self->count > 0) {
+		band = self->data + self->tail * self->band_size;
+		*y = self->band_y[self->tail];
+		*rows = self->band_rows[self->tail];
+	}
+	pthread_mutex_unlock(&self->mutex);
+
+	return band;
+}
+
+void band_queue_release(band_queue_t *self)
+{
+	pthread_mutex_lock(&self->mutex);
+
+	self->tail = (self->tail + 1) % self->capacity;
+	self->count -= 1;
+
+	pthread_cond_signal(&self->not_full);
+	pthread_mutex_unlock(&self->mutex);
+}
@@ -0,0 +1,54 @@
+#ifndef __PDF2LASER_TYPE_BAND_QUEUE_H__
+#define __PDF2LASER_TYPE_BAND_QUEUE_H__ 1
+
+#include <pthread.h>  // for pthread_cond_t, pthread_mutex_t
+#include <stdbool.h>  // for bool
+#include <stddef.h>   // for size_t
+#include <stdint.h>   // for int32_t, uint8_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+/**
+ * Bounded single producer, single consumer queue of raster bands. The
+ * producer acquires a free slot, renders into it and publishes it; the
+ * consumer peeks at the oldest published band and releases it once encoded.
+ */
+typedef struct band_queue band_queue_t;
+struct band_queue {
+	uint8_t *data;
+	size_t band_size;
+	size_t capacity;
+
+	int32_t *band_y;
+	int32_t *band_rows;
+
+	size_t head;
+	size_t tail;
+	size_t count;
+	bool closed;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t not_full;
+	pthread_cond_t not_empty;
+};
+
+band_queue_t *band_queue_create(size_t capacity, size_t band_size);
+band_queue_t *band_queue_destroy(band_queue_t *self);
+
+uint8_t *band_queue_acquire(band_queue_t *self);
+void band_queue_publish(band_queue_t *self, int32_t y, int32_t rows);
+void band_queue_close(band_queue_t *self);
+
+uint8_t *band_queue_peek(band_queue_t *self, int32_t *y, int32_t *rows);
+void band_queue_release(band_queue_t *self);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
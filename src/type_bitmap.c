@@ -0,0 +1,39 @@
+#include "type_bitmap.h"
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for int32_t, uint8_t
+#include <stdlib.h>  // for calloc, free, NULL
+
+bitmap_t *bitmap_create(int32_t width, int32_t height, int32_t raster)
+{
+	bitmap_t *bitmap = calloc(1, sizeof(bitmap_t));
+	if (bitmap == NULL)
+		return NULL;
+
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->raster = raster;
+
+	bitmap->data = calloc((size_t)height, (size_t)raster);
+	if (bitmap->data == NULL) {
+		free(bitmap);
+		return NULL;
+	}
+
+	return bitmap;
+}
+
+bitmap_t *bitmap_destroy(bitmap_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	free(self->data);
+	free(self);
+
+	return NULL;
+}
+
+uint8_t *bitmap_row(bitmap_t *self, int32_t y)
+{
+	return self->data + (size_t)y * (size_t)self->raster;
+}
@@ -0,0 +1,34 @@
+#ifndef __PDF2LASER_TYPE_BITMAP_H__
+#define __PDF2LASER_TYPE_BITMAP_H__ 1
+
+#include <stdint.h>  // for int32_t, uint8_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+typedef struct bitmap bitmap_t;
+struct bitmap {
+	int32_t width;
+	int32_t height;
+
+	// number of bytes between the start of two rows
+	int32_t raster;
+
+	// rows are stored top first
+	uint8_t *data;
+};
+
+bitmap_t *bitmap_create(int32_t width, int32_t height, int32_t raster);
+bitmap_t *bitmap_destroy(bitmap_t *self);
+
+uint8_t *bitmap_row(bitmap_t *self, int32_t y);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+#include "type_hpgl_buffer.h"
+#include <stdbool.h>  // for bool, false, true
+#include <stddef.h>   // for size_t, NULL
+#include <stdint.h>   // for int32_t, uint32_t
+#include <stdio.h>    // for FILE, fwrite
+#include <stdlib.h>   // for calloc, free, realloc
+#include <string.h>   // for memcpy
+
+// Two digit pairs, "00" to "99", so numbers are formatted two digits a step
+static const char hpgl_buffer_digits[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+hpgl_buffer_t *hpgl_buffer_create(void)
+{
+	hpgl_buffer_t *hpgl_buffer = calloc(1, sizeof(hpgl_buffer_t));
+	if (hpgl_buffer == NULL)
+		return NULL;
+
+	hpgl_buffer->data = NULL;
+	hpgl_buffer->length = 0;
+	hpgl_buffer->capacity = 0;
+
+	return hpgl_buffer;
+}
+
+hpgl_buffer_t *hpgl_buffer_destroy(hpgl_buffer_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	free(self->data);
+	free(self);
+
+	return NULL;
+}
+
+static bool hpgl_buffer_reserve(hpgl_buffer_t *self, size_t count)
+{
+	if (self->length + count <= self->capacity)
+		return true;
+
+	size_t capacity = (self->capacity > 0) ? self->capacity : HPGL_BUFFER_INITIAL_CAPACITY;
+	while (capacity < self->length + count)
+		capacity *= 2;
+
+	char *data = realloc(self->data, capacity);
+	if (data == NULL)
+		return false;
+
+	self->data = data;
+	self->capacity = capacity;
+	return true;
+}
+
+/**
+ * Format a number in decimal at cursor, which must have room for 11 bytes.
+ *
+ * @return The position just past the last digit.
+ */
+static char *hpgl_buffer_format(char *cursor, int32_t value)
+{
+	uint32_t magnitude = (uint32_t)value;
+	if (value < 0) {
+		*cursor++ = '-';
+		magnitude = 0u - magnitude;
+	}
+
+	char digits[10];
+	char *start = digits + sizeof(digits);
+	while (magnitude >= 100) {
+		uint32_t pair = magnitude % 100;
+		magnitude /= 100;
+		start -= 2;
+		memcpy(start, &hpgl_buffer_digits[2 * pair], 2);
+	}
+	if (magnitude >= 10) {
+		start -= 2;
+		memcpy(start, &hpgl_buffer_digits[2 * magnitude], 2);
+	}
+	else {
+		*--start = (char)('0' + magnitude);
+	}
+
+	size_t count = (size_t)(digits + sizeof(digits) - start);
+	memcpy(cursor, start, count);
+	return cursor + count;
+}
+
+/**
+ * Empty the buffer, keeping its storage for the next pass.
+ */
+hpgl_buffer_t *hpgl_buffer_clear(hpgl_buffer_t *self)
+{
+	self->length = 0;
+	return self;
+}
+
+/**
+ * Add raw bytes to the end of the buffer.
+ *
+ * @return The buffer, NULL if it could not grow.
+ */
+hpgl_buffer_t *hpgl_buffer_append(hpgl_buffer_t *self, const char *data, size_t length)
+{
+	if (!hpgl_buffer_reserve(self, length))
+		return NULL;
+
+	memcpy(self->data + self->length, data, length);
+	self->length += length;
+
+	return self;
+}
+
+/**
+ * Add a prefix of up to four bytes followed by two comma separated numbers,
+ * the shape of every coordinate HPGL takes, e.g. ";PD" 10 20 as ";PD10,20".
+ *
+ * @return The buffer, NULL if it could not grow.
+ */
+hpgl_buffer_t *hpgl_buffer_add_pair(hpgl_buffer_t *self, const char *prefix, int32_t first, int32_t second)
+{
+	if (!hpgl_buffer_reserve(self, HPGL_BUFFER_PAIR_NBYTES))
+		return NULL;
+
+	char *cursor = self->data + self->length;
+	while (*prefix != '\0')
+		*cursor++ = *prefix++;
+
+	cursor = hpgl_buffer_format(cursor, first);
+	*cursor++ = ',';
+	cursor = hpgl_buffer_format(cursor, second);
+
+	self->length = (size_t)(cursor - self->data);
+	return self;
+}
+
+/**
+ * Write the whole buffer to a stream in one call.
+ *
+ * @return true if every byte was written.
+ */
+bool hpgl_buffer_write(hpgl_buffer_t *self, FILE *stream)
+{
+	if (self->length == 0)
+		return true;
+
+	return fwrite(self->data, 1, self->length, stream) == self->length;
+}
@@ -0,0 +1,46 @@
+#ifndef __PDF2LASER_TYPE_HPGL_BUFFER_H__
+#define __PDF2LASER_TYPE_HPGL_BUFFER_H__ 1
+
+#include <stdbool.h>  // for bool
+#include <stddef.h>   // for size_t
+#include <stdint.h>   // for int32_t
+#include <stdio.h>    // for FILE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+// Bytes a buffer makes room for on its first write, doubled as it fills
+#define HPGL_BUFFER_INITIAL_CAPACITY (65536)
+
+// Most bytes hpgl_buffer_add_pair writes for a prefix of up to four bytes
+#define HPGL_BUFFER_PAIR_NBYTES (4 + 11 + 1 + 11)
+
+/**
+ * Growable buffer HPGL commands are rendered into, so a vector pass is
+ * formatted once and can be written out whole, as often as it is repeated.
+ */
+typedef struct hpgl_buffer hpgl_buffer_t;
+struct hpgl_buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+};
+
+hpgl_buffer_t *hpgl_buffer_create(void);
+hpgl_buffer_t *hpgl_buffer_destroy(hpgl_buffer_t *self);
+
+hpgl_buffer_t *hpgl_buffer_clear(hpgl_buffer_t *self);
+hpgl_buffer_t *hpgl_buffer_append(hpgl_buffer_t *self, const char *data, size_t length);
+hpgl_buffer_t *hpgl_buffer_add_pair(hpgl_buffer_t *self, const char *prefix, int32_t first, int32_t second);
+
+bool hpgl_buffer_write(hpgl_buffer_t *self, FILE *stream);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+#include "type_kinematics.h"
+#include <math.h>         // for sqrt
+#include <stdint.h>       // for int32_t
+#include <stdlib.h>       // for calloc, free, NULL
+#include "config.h"       // for CORNER_PENALTY_DEFAULT, POSITION_PRECISION_DEFAULT, RESOLUTION_DEFAULT, TRANSIT_ACCELERATION_DEFAULT, TRANSIT_SPEED_DEFAULT
+#include "type_point.h"   // for point_t
+
+kinematics_t *kinematics_create(void)
+{
+	kinematics_t *kinematics = calloc(1, sizeof(kinematics_t));
+
+	kinematics->speed = TRANSIT_SPEED_DEFAULT;
+	kinematics->acceleration = TRANSIT_ACCELERATION_DEFAULT;
+	kinematics->corner = CORNER_PENALTY_DEFAULT;
+	kinematics->precision = POSITION_PRECISION_DEFAULT;
+	kinematics->resolution = RESOLUTION_DEFAULT;
+
+	return kinematics;
+}
+
+kinematics_t *kinematics_destroy(kinematics_t *self)
+{
+	free(self);
+	return NULL;
+}
+
+/**
+ * Furthest, in device units, a flattened curve may stray from the true one.
+ * Finer than the head can position itself is wasted, as is finer than half
+ * a device unit since points are rounded to whole units anyway.
+ *
+ * @param self the model.
+ * @param resolution device units per inch.
+ */
+double kinematics_flatness(kinematics_t *self, uint32_t resolution)
+{
+	double units = ((resolution > 0) ? resolution : RESOLUTION_DEFAULT) / 25400.0;
+	double flatness = self->precision * units;
+
+	return (flatness > 0.5) ? flatness : 0.5;
+}
+
+/**
+ * Seconds the head takes to cover a distance from rest to rest, accelerating
+ * up to top speed and back down, or only part way on short hops.
+ *
+ * @param self the model.
+ * @param distance the distance in mm.
+ */
+double kinematics_transit_time(kinematics_t *self, double distance)
+{
+	if (distance <= 0.0)
+		return 0.0;
+
+	double speed = (self->speed > 0) ? self->speed : 1.0;
+	if (self->acceleration <= 0)
+		return distance / speed;
+
+	double acceleration = self->acceleration;
+	if (distance < speed * speed / acceleration)
+		return 2.0 * sqrt(distance / acceleration);
+
+	return distance / speed + speed / acceleration;
+}
+
+/*
+ * Fraction of a full reversal turning from direction a to direction b, 0 for
+ * straight on, 1 for straight back.
+ */
+static double kinematics_turn(double ax, double ay, double bx, double by)
+{
+	double a = sqrt(ax * ax + ay * ay);
+	double b = sqrt(bx * bx + by * by);
+	if (a == 0.0 || b == 0.0)
+		return 0.0;
+
+	return (1.0 - (ax * bx + ay * by) / (a * b)) / 2.0;
+}
+
+/**
+ * Seconds lost between finishing one cut and starting the next, the transit
+ * itself plus the turns onto and off it.
+ *
+ * @param self the model.
+ * @param from_inner the point the finished cut came from.
+ * @param from the point the finished cut ends at.
+ * @param to the point the next cut starts at.
+ * @param to_inner the point the next cut heads for.
+ */
+double kinematics_link_time(kinematics_t *self, const point_t *from_inner, const point_t *from,
+                            const point_t *to, const point_t *to_inner)
+{
+	double units = ((self->resolution > 0) ? self->resolution : RESOLUTION_DEFAULT) / 25.4;
+
+	double in_x = (double)from->x - from_inner->x, in_y = (double)from->y - from_inner->y;
+	double transit_x = (double)to->x - from->x, transit_y = (double)to->y - from->y;
+	double out_x = (double)to_inner->x - to->x, out_y = (double)to_inner->y - to->y;
+
+	double distance = sqrt(transit_x * transit_x + transit_y * transit_y);
+	double time = kinematics_transit_time(self, distance / units);
+
+	if (self->corner > 0) {
+		double turns = (distance > 0.0) ?
+			kinematics_turn(in_x, in_y, transit_x, transit_y) + kinematics_turn(transit_x, transit_y, out_x, out_y) :
+			kinematics_turn(in_x, in_y, out_x, out_y);
+		time += turns * self->corner / 1000.0;
+	}
+
+	return time;
+}
@@ -0,0 +1,40 @@
+#ifndef __PDF2LASER_TYPE_KINEMATICS_H__
+#define __PDF2LASER_TYPE_KINEMATICS_H__ 1
+
+#include <stdint.h>       // for int32_t, uint32_t
+#include "type_point.h"   // for point_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+/**
+ * Model of how the head moves between cuts, used to estimate the time a
+ * transit takes rather than its length, and of how finely it can follow a
+ * curve.
+ */
+typedef struct kinematics kinematics_t;
+struct kinematics {
+	int32_t speed;         // Top transit speed in mm/s
+	int32_t acceleration;  // Head acceleration in mm/s^2
+	int32_t corner;        // Time lost to a full reversal of direction in ms
+	int32_t precision;     // Positional precision of the head in um
+	uint32_t resolution;   // Device units per inch of the points given
+};
+
+kinematics_t *kinematics_create(void);
+kinematics_t *kinematics_destroy(kinematics_t *self);
+
+double kinematics_flatness(kinematics_t *self, uint32_t resolution);
+double kinematics_transit_time(kinematics_t *self, double distance);
+double kinematics_link_time(kinematics_t *self, const point_t *from_inner, const point_t *from,
+                            const point_t *to, const point_t *to_inner);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
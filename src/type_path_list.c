@@ -0,0 +1,1972 @@
+#include "type_path_list.h"
+#include <inttypes.h>          // for PRId64
+#include <math.h>              // for fabs, sqrt, INFINITY
+#include <stdbool.h>           // for bool, false, true
+#include <stddef.h>            // for size_t, NULL
+#include <stdint.h>            // for int32_t, int64_t, uint32_t, SIZE_MAX
+#include <stdio.h>             // for FILE, fprintf
+#include <stdlib.h>            // for calloc, free, realloc, qsort
+#include <time.h>              // for clock_gettime, timespec, CLOCK_MONOTONIC
+#include "type_kinematics.h"   // for kinematics_t, kinematics_link_time
+#include "type_point.h"        // for point_t, point_distance_squared
+#include "type_vector.h"       // for vector_t
+#include "type_vector_grid.h"  // for vector_grid_t, vector_grid_create, vector_grid_destroy, vector_grid_nearest, vector_grid_take_closest
+#include "type_vector_list.h"  // for vector_list_t, vector_list_append, vector_list_create, vector_list_destroy
+
+path_list_t *path_list_create(void)
+{
+	path_list_t *path_list = calloc(1, sizeof(path_list_t));
+	if (path_list == NULL)
+		return NULL;
+
+	path_list->x = NULL;
+	path_list->y = NULL;
+	path_list->point_count = 0;
+	path_list->point_capacity = 0;
+
+	path_list->offsets = calloc(PATH_LIST_INITIAL_CAPACITY + 1, sizeof(size_t));
+	if (path_list->offsets == NULL) {
+		free(path_list);
+		return NULL;
+	}
+	path_list->length = 0;
+	path_list->capacity = PATH_LIST_INITIAL_CAPACITY;
+	path_list->group = NULL;
+
+	return path_list;
+}
+
+path_list_t *path_list_destroy(path_list_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	free(self->x);
+	free(self->y);
+	free(self->offsets);
+	free(self->group);
+	free(self);
+
+	return NULL;
+}
+
+/**
+ * Start a new, empty, path at the end of the list.
+ *
+ * @return The list, NULL if it could not grow.
+ */
+path_list_t *path_list_begin(path_list_t *self)
+{
+	if (self->length == self->capacity) {
+		size_t capacity = self->capacity * 2;
+		size_t *offsets = realloc(self->offsets, (capacity + 1) * sizeof(size_t));
+		if (offsets == NULL)
+			return NULL;
+		self->offsets = offsets;
+		self->capacity = capacity;
+	}
+
+	self->length += 1;
+	self->offsets[self->length] = self->point_count;
+
+	return self;
+}
+
+/**
+ * Extend the last path by one point.
+ *
+ * @return The list, NULL if it could not grow.
+ */
+path_list_t *path_list_add_point(path_list_t *self, int32_t x, int32_t y)
+{
+	if (self->point_count == self->point_capacity) {
+		size_t capacity = (self->point_capacity > 0) ? self->point_capacity * 2 : PATH_LIST_INITIAL_CAPACITY;
+		int32_t *xs = realloc(self->x, capacity * sizeof(int32_t));
+		if (xs == NULL)
+			return NULL;
+		self->x = xs;
+		int32_t *ys = realloc(self->y, capacity * sizeof(int32_t));
+		if (ys == NULL)
+			return NULL;
+		self->y = ys;
+		self->point_capacity = capacity;
+	}
+
+	self->x[self->point_count] = x;
+	self->y[self->point_count] = y;
+	self->point_count += 1;
+	self->offsets[self->length] = self->point_count;
+
+	return self;
+}
+
+/**
+ * Copy a path of another list onto the end of this one.
+ *
+ * @param self the list to extend.
+ * @param other the list holding the path.
+ * @param index the path to copy.
+ * @param reverse whether to copy the points last to first.
+ *
+ * @return The list, NULL if it could not grow.
+ */
+path_list_t *path_list_append_path(path_list_t *self, path_list_t *other, size_t index, bool reverse)
+{
+	if (path_list_begin(self) == NULL)
+		return NULL;
+
+	size_t first = other->offsets[index];
+	size_t count = path_list_points(other, index);
+	for (size_t point = 0; point < count; point += 1) {
+		size_t source = first + (reverse ? count - 1 - point : point);
+		if (path_list_add_point(self, other->x[source], other->y[source]) == NULL)
+			return NULL;
+	}
+
+	return self;
+}
+
+size_t path_list_points(path_list_t *self, size_t index)
+{
+	return self->offsets[index + 1] - self->offsets[index];
+}
+
+/**
+ * Whether a path ends where it starts.
+ */
+bool path_list_closed(path_list_t *self, size_t index)
+{
+	size_t first = self->offsets[index];
+	size_t last = self->offsets[index + 1] - 1;
+	return path_list_points(self, index) > 2 &&
+		self->x[first] == self->x[last] && self->y[first] == self->y[last];
+}
+
+/*
+ * Endpoints of the vectors being chained, sorted by position so that equal
+ * points become one node of the graph.
+ */
+struct path_list_endpoint {
+	int32_t x;
+	int32_t y;
+	size_t entry;
+};
+
+static int path_list_endpoint_compare(const void *a, const void *b)
+{
+	const struct path_list_endpoint *self = a;
+	const struct path_list_endpoint *other = b;
+
+	if (self->x != other->x)
+		return (self->x < other->x) ? -1 : 1;
+	if (self->y != other->y)
+		return (self->y < other->y) ? -1 : 1;
+	return (self->entry < other->entry) ? -1 : (self->entry > other->entry);
+}
+
+/*
+ * Graph of the vectors, edges 0 to vectors - 1 are the vectors themselves,
+ * those after are virtual edges pairing up odd nodes so that every component
+ * has an Euler circuit.
+ */
+struct path_list_graph {
+	size_t nodes;
+	int32_t *node_x;
+	int32_t *node_y;
+
+	size_t vectors;
+	size_t edges;
+	size_t *edge_from;
+	size_t *edge_to;
+	bool *edge_used;
+
+	size_t *adjacency_start;
+	size_t *adjacency;
+};
+
+static void path_list_graph_free(struct path_list_graph *graph)
+{
+	free(graph->node_x);
+	free(graph->node_y);
+	free(graph->edge_from);
+	free(graph->edge_to);
+	free(graph->edge_used);
+	free(graph->adjacency_start);
+	free(graph->adjacency);
+}
+
+static bool path_list_graph_build(struct path_list_graph *graph, vector_list_t *list)
+{
+	size_t vectors = list->length;
+	size_t endpoints_count = 2 * vectors;
+
+	struct path_list_endpoint *endpoints = calloc(endpoints_count + 1, sizeof(struct path_list_endpoint));
+	size_t *endpoint_node = calloc(endpoints_count + 1, sizeof(size_t));
+	if (endpoints == NULL || endpoint_node == NULL) {
+		free(endpoints);
+		free(endpoint_node);
+		return false;
+	}
+
+	for (size_t index = 0; index < vectors; index += 1) {
+		endpoints[2 * index] = (struct path_list_endpoint){ list->start_x[index], list->start_y[index], 2 * index };
+		endpoints[2 * index + 1] = (struct path_list_endpoint){ list->end_x[index], list->end_y[index], 2 * index + 1 };
+	}
+	qsort(endpoints, endpoints_count, sizeof(struct path_list_endpoint), path_list_endpoint_compare);
+
+	// Every node can gain at most one virtual edge
+	graph->node_x = calloc(endpoints_count + 1, sizeof(int32_t));
+	graph->node_y = calloc(endpoints_count + 1, sizeof(int32_t));
+	graph->edge_from = calloc(vectors + endpoints_count / 2 + 1, sizeof(size_t));
+	graph->edge_to = calloc(vectors + endpoints_count / 2 + 1, sizeof(size_t));
+	if (graph->node_x == NULL || graph->node_y == NULL || graph->edge_from == NULL || graph->edge_to == NULL) {
+		free(endpoints);
+		free(endpoint_node);
+		return false;
+	}
+
+	graph->nodes = 0;
+	for (size_t index = 0; index < endpoints_count; index += 1) {
+		if (index == 0 || endpoints[index].x != endpoints[index - 1].x || endpoints[index].y != endpoints[index - 1].y) {
+			graph->node_x[graph->nodes] = endpoints[index].x;
+			graph->node_y[graph->nodes] = endpoints[index].y;
+			graph->nodes += 1;
+		}
+		endpoint_node[endpoints[index].entry] = graph->nodes - 1;
+	}
+	free(endpoints);
+
+	graph->vectors = vectors;
+	for (size_t index = 0; index < vectors; index += 1) {
+		graph->edge_from[index] = endpoint_node[2 * index];
+		graph->edge_to[index] = endpoint_node[2 * index + 1];
+	}
+	free(endpoint_node);
+
+	size_t *degree = calloc(graph->nodes + 1, sizeof(size_t));
+	if (degree == NULL)
+		return false;
+
+	for (size_t index = 0; index < vectors; index += 1) {
+		degree[graph->edge_from[index]] += 1;
+		degree[graph->edge_to[index]] += 1;
+	}
+
+	// Pair the odd nodes in order, there is always an even number of them
+	graph->edges = vectors;
+	size_t odd = SIZE_MAX;
+	for (size_t node = 0; node < graph->nodes; node += 1) {
+		if (degree[node] % 2 == 0)
+			continue;
+		if (odd == SIZE_MAX) {
+			odd = node;
+			continue;
+		}
+		graph->edge_from[graph->edges] = odd;
+		graph->edge_to[graph->edges] = node;
+		graph->edges += 1;
+		degree[odd] += 1;
+		degree[node] += 1;
+		odd = SIZE_MAX;
+	}
+
+	graph->edge_used = calloc(graph->edges + 1, sizeof(bool));
+	graph->adjacency_start = calloc(graph->nodes + 2, sizeof(size_t));
+	graph->adjacency = calloc(2 * graph->edges + 1, sizeof(size_t));
+	if (graph->edge_used == NULL || graph->adjacency_start == NULL || graph->adjacency == NULL) {
+		free(degree);
+		return false;
+	}
+
+	for (size_t node = 0; node < graph->nodes; node += 1)
+		graph->adjacency_start[node + 1] = graph->adjacency_start[node] + degree[node];
+
+	// Reuse degree as the fill count of each node
+	for (size_t node = 0; node < graph->nodes; node += 1)
+		degree[node] = 0;
+
+	for (size_t edge = 0; edge < graph->edges; edge += 1) {
+		size_t from = graph->edge_from[edge];
+		size_t to = graph->edge_to[edge];
+		graph->adjacency[graph->adjacency_start[from] + degree[from]++] = edge;
+		graph->adjacency[graph->adjacency_start[to] + degree[to]++] = edge;
+	}
+
+	free(degree);
+
+	return true;
+}
+
+/**
+ * Append the circuit found by Hierholzer's algorithm as paths, splitting it
+ * at virtual edges. A circuit without virtual edges is one closed path.
+ *
+ * @param circuit_node the nodes of the circuit, count + 1 of them with the
+ * last equal to the first.
+ * @param circuit_edge the edges, circuit_edge[i] joins node i to node i + 1.
+ * @param count number of edges.
+ */
+static bool path_list_add_circuit(path_list_t *self, struct path_list_graph *graph,
+                                  const size_t *circuit_node, const size_t *circuit_edge, size_t count)
+{
+	// Start right after a virtual edge, if there is one
+	size_t first = 0;
+	for (size_t index = 0; index < count; index += 1) {
+		if (circuit_edge[index] >= graph->vectors) {
+			first = index + 1;
+			break;
+		}
+	}
+
+	bool open = false;
+	for (size_t step = 0; step < count; step += 1) {
+		size_t index = (first + step) % count;
+		size_t edge = circuit_edge[index];
+
+		if (edge >= graph->vectors) {
+			open = false;
+			continue;
+		}
+
+		if (!open) {
+			size_t node = circuit_node[index];
+			if (path_list_begin(self) == NULL ||
+			    path_list_add_point(self, graph->node_x[node], graph->node_y[node]) == NULL)
+				return false;
+			open = true;
+		}
+
+		size_t node = circuit_node[index + 1];
+		if (path_list_add_point(self, graph->node_x[node], graph->node_y[node]) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Split vectors into paths where one does not start at the end of the one
+ * before it, keeping their order and direction.
+ *
+ * @param list the vectors to split, left untouched.
+ *
+ * @return A new path list, NULL on allocation failure.
+ */
+path_list_t *path_list_from_vector_list(vector_list_t *list)
+{
+	path_list_t *path_list = path_list_create();
+	if (path_list == NULL)
+		return NULL;
+
+	for (size_t index = 0; index < list->length; index += 1) {
+		bool joined = index > 0 &&
+			list->start_x[index] == list->end_x[index - 1] && list->start_y[index] == list->end_y[index - 1];
+
+		if (!joined) {
+			if (path_list_begin(path_list) == NULL ||
+			    path_list_add_point(path_list, list->start_x[index], list->start_y[index]) == NULL)
+				return path_list_destroy(path_list);
+		}
+
+		if (path_list_add_point(path_list, list->end_x[index], list->end_y[index]) == NULL)
+			return path_list_destroy(path_list);
+	}
+
+	return path_list;
+}
+
+/**
+ * Chain vectors sharing endpoints into as few polylines as the graph allows.
+ * Each connected group of vectors with 2k odd nodes becomes k open paths, or
+ * one closed path when it has none. Vectors may end up cut in reverse.
+ *
+ * @param list the vectors to chain, left untouched.
+ *
+ * @return A new path list, NULL on allocation failure.
+ */
+path_list_t *path_list_chain(vector_list_t *list)
+{
+	path_list_t *path_list = path_list_create();
+	if (path_list == NULL)
+		return NULL;
+
+	struct path_list_graph graph = { 0 };
+	if (!path_list_graph_build(&graph, list)) {
+		path_list_graph_free(&graph);
+		return path_list_destroy(path_list);
+	}
+
+	// Stack of the walk, and the circuit as nodes are popped off it
+	size_t *stack_node = calloc(graph.edges + 2, sizeof(size_t));
+	size_t *stack_edge = calloc(graph.edges + 2, sizeof(size_t));
+	size_t *circuit_node = calloc(graph.edges + 2, sizeof(size_t));
+	size_t *circuit_edge = calloc(graph.edges + 2, sizeof(size_t));
+	size_t *next = calloc(graph.nodes + 1, sizeof(size_t));
+	if (stack_node == NULL || stack_edge == NULL || circuit_node == NULL || circuit_edge == NULL || next == NULL)
+		goto path_list_chain_fail;
+
+	for (size_t node = 0; node < graph.nodes; node += 1)
+		next[node] = graph.adjacency_start[node];
+
+	for (size_t start = 0; start < graph.nodes; start += 1) {
+		size_t depth = 0;
+		size_t count = 0;
+
+		stack_node[depth] = start;
+		stack_edge[depth] = SIZE_MAX;
+		depth += 1;
+
+		while (depth > 0) {
+			size_t node = stack_node[depth - 1];
+
+			while (next[node] < graph.adjacency_start[node + 1] && graph.edge_used[graph.adjacency[next[node]]])
+				next[node] += 1;
+
+			if (next[node] < graph.adjacency_start[node + 1]) {
+				size_t edge = graph.adjacency[next[node]];
+				graph.edge_used[edge] = true;
+				stack_node[depth] = (graph.edge_from[edge] == node) ? graph.edge_to[edge] : graph.edge_from[edge];
+				stack_edge[depth] = edge;
+				depth += 1;
+			}
+			else {
+				depth -= 1;
+				circuit_node[count] = stack_node[depth];
+				circuit_edge[count] = stack_edge[depth];
+				count += 1;
+			}
+		}
+
+		// A node with nothing left to walk pops straight back off
+		if (count > 1 && !path_list_add_circuit(path_list, &graph, circuit_node, circuit_edge, count - 1))
+			goto path_list_chain_fail;
+	}
+
+	free(stack_node);
+	free(stack_edge);
+	free(circuit_node);
+	free(circuit_edge);
+	free(next);
+	path_list_graph_free(&graph);
+
+	return path_list;
+
+ path_list_chain_fail:
+	free(stack_node);
+	free(stack_edge);
+	free(circuit_node);
+	free(circuit_edge);
+	free(next);
+	path_list_graph_free(&graph);
+
+	return path_list_destroy(path_list);
+}
+
+/*
+ * An end of a path, with the point next to it inside the path giving the
+ * direction the head arrives or leaves in. Both are the same point for a path
+ * of one point, and for the origin.
+ */
+struct path_list_end {
+	point_t point;
+	point_t inner;
+};
+
+static double path_list_distance(const point_t *a, const point_t *b)
+{
+	double dx = (double)a->x - (double)b->x;
+	double dy = (double)a->y - (double)b->y;
+	return sqrt(dx * dx + dy * dy);
+}
+
+/*
+ * Cost of going from one path end to another, the time the machine model
+ * estimates.
+ */
+static double path_list_link(kinematics_t *kinematics, const struct path_list_end *from, const struct path_list_end *to)
+{
+	return kinematics_link_time(kinematics, &from->inner, &from->point, &to->point, &to->inner);
+}
+
+/*
+ * Point a path is left from, after cutting it in the order it is stored.
+ */
+static struct path_list_end path_list_exit(path_list_t *self, size_t index)
+{
+	size_t last = self->offsets[index + 1] - 1;
+	size_t inner = (last > self->offsets[index]) ? last - 1 : last;
+	return (struct path_list_end){ { self->x[last], self->y[last] }, { self->x[inner], self->y[inner] } };
+}
+
+static struct path_list_end path_list_entry(path_list_t *self, size_t index)
+{
+	size_t first = self->offsets[index];
+	size_t inner = (first + 1 < self->offsets[index + 1]) ? first + 1 : first;
+	return (struct path_list_end){ { self->x[first], self->y[first] }, { self->x[inner], self->y[inner] } };
+}
+
+/*
+ * Offset into a closed path of its step'th point when going round it from a
+ * vertex, forwards or backwards. The last point repeats the first, so a
+ * path of count + 1 points has count vertices.
+ */
+static size_t path_list_loop_point(size_t count, size_t vertex, size_t step, bool reverse)
+{
+	return reverse ? (vertex + count - step % count) % count : (vertex + step) % count;
+}
+
+/*
+ * The end a closed path is entered at, and left from, going round it from a
+ * vertex.
+ */
+static struct path_list_end path_list_loop_entry(path_list_t *self, size_t index, size_t vertex, bool reverse)
+{
+	size_t first = self->offsets[index];
+	size_t count = path_list_points(self, index) - 1;
+	size_t inner = first + path_list_loop_point(count, vertex, 1, reverse);
+	return (struct path_list_end){
+		{ self->x[first + vertex], self->y[first + vertex] }, { self->x[inner], self->y[inner] }
+	};
+}
+
+static struct path_list_end path_list_loop_exit(path_list_t *self, size_t index, size_t vertex, bool reverse)
+{
+	size_t first = self->offsets[index];
+	size_t count = path_list_points(self, index) - 1;
+	size_t inner = first + path_list_loop_point(count, vertex, count - 1, reverse);
+	return (struct path_list_end){
+		{ self->x[first + vertex], self->y[first + vertex] }, { self->x[inner], self->y[inner] }
+	};
+}
+
+/**
+ * Copy a closed path of another list onto the end of this one, going round
+ * it from another of its points.
+ *
+ * @param self the list to extend.
+ * @param other the list holding the path.
+ * @param index the closed path to copy.
+ * @param vertex the point to start and end at, as an offset into the path.
+ * @param reverse whether to go round the path backwards.
+ *
+ * @return The list, NULL if it could not grow.
+ */
+path_list_t *path_list_append_rotated(path_list_t *self, path_list_t *other, size_t index, size_t vertex, bool reverse)
+{
+	if (path_list_begin(self) == NULL)
+		return NULL;
+
+	size_t first = other->offsets[index];
+	size_t count = path_list_points(other, index) - 1;
+	for (size_t step = 0; step <= count; step += 1) {
+		size_t source = first + path_list_loop_point(count, vertex, step, reverse);
+		if (path_list_add_point(self, other->x[source], other->y[source]) == NULL)
+			return NULL;
+	}
+
+	return self;
+}
+
+/**
+ * The first and last point of every path, as vectors a grid can index.
+ *
+ * @return A new vector list, NULL on allocation failure.
+ */
+static vector_list_t *path_list_ends(path_list_t *self)
+{
+	vector_list_t *ends = vector_list_create();
+	if (ends == NULL)
+		return NULL;
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		size_t first = self->offsets[index];
+		size_t last = self->offsets[index + 1] - 1;
+		vector_t vector = { { self->x[first], self->y[first] }, { self->x[last], self->y[last] } };
+		if (vector_list_append(ends, &vector) == NULL)
+			return vector_list_destroy(ends);
+	}
+
+	return ends;
+}
+
+/*
+ * Cost of moving the head onto a path where the grid found it, entering an
+ * open path at either end and going either way round a closed one.
+ *
+ * @param reverse set when the open path is best cut from its last point.
+ */
+static double path_list_entry_link(path_list_t *self, size_t index, size_t vertex, kinematics_t *kinematics,
+                                   const struct path_list_end *current, bool *reverse)
+{
+	struct path_list_end forwards, backwards;
+	if (path_list_closed(self, index)) {
+		forwards = path_list_loop_entry(self, index, vertex, false);
+		backwards = path_list_loop_entry(self, index, vertex, true);
+	} else {
+		forwards = path_list_entry(self, index);
+		backwards = path_list_exit(self, index);
+	}
+
+	double forwards_cost = path_list_link(kinematics, current, &forwards);
+	double backwards_cost = path_list_link(kinematics, current, &backwards);
+	*reverse = backwards_cost < forwards_cost;
+
+	return *reverse ? backwards_cost : forwards_cost;
+}
+
+/*
+ * Append a path to an ordered list, entering it where the grid found it, in
+ * the direction path_list_entry_link chose. Closed paths are gone round from
+ * the vertex found.
+ */
+static path_list_t *path_list_append_entered(path_list_t *path_list, path_list_t *self, size_t index, size_t vertex,
+                                             bool reverse)
+{
+	if (!path_list_closed(self, index))
+		return path_list_append_path(path_list, self, index, reverse);
+
+	return path_list_append_rotated(path_list, self, index, vertex, reverse);
+}
+
+/*
+ * Add the entries a grid finds a path by to a vector list, its two ends when
+ * open, each of its points when closed, owned by the given id.
+ */
+static bool path_list_add_entries(path_list_t *self, size_t index, vector_list_t *ends, size_t *owner, size_t id)
+{
+	size_t first = self->offsets[index];
+	size_t last = self->offsets[index + 1] - 1;
+
+	if (!path_list_closed(self, index)) {
+		vector_t vector = { { self->x[first], self->y[first] }, { self->x[last], self->y[last] } };
+		owner[ends->length] = id;
+		return vector_list_append(ends, &vector) != NULL;
+	}
+
+	for (size_t point = first; point < last; point += 1) {
+		vector_t vector = { { self->x[point], self->y[point] }, { self->x[point], self->y[point] } };
+		owner[ends->length] = id;
+		if (vector_list_append(ends, &vector) == NULL)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Number of entries path_list_add_entries adds for a path.
+ */
+static size_t path_list_count_entries(path_list_t *self, size_t index)
+{
+	return path_list_closed(self, index) ? path_list_points(self, index) - 1 : 1;
+}
+
+/*
+ * Nearest point of a closed path to an end, as an offset into the path.
+ */
+static size_t path_list_nearest_vertex(path_list_t *self, size_t index, const point_t *point)
+{
+	size_t first = self->offsets[index];
+	size_t count = path_list_points(self, index) - 1;
+
+	size_t best_vertex = 0;
+	int64_t best_distance = INT64_MAX;
+	for (size_t vertex = 0; vertex < count; vertex += 1) {
+		point_t candidate = { self->x[first + vertex], self->y[first + vertex] };
+		int64_t distance = point_distance_squared(point, &candidate);
+		if (distance < best_distance) {
+			best_distance = distance;
+			best_vertex = vertex;
+		}
+	}
+
+	return best_vertex;
+}
+
+/*
+ * Greedily order some of the paths of a list onto the end of another. Of the
+ * few paths with an end nearest the head, the one the machine model makes
+ * quickest to reach, turns included, is cut next.
+ *
+ * @param self the list holding the paths.
+ * @param path_list the list to append to.
+ * @param paths the indices of the paths to order.
+ * @param count the number of them.
+ * @param parent the path each path lies directly inside, SIZE_MAX for none,
+ * or NULL to cut the paths in any order. Paths with others inside are then
+ * held back until those are cut.
+ * @param remaining per path, the paths directly inside it still to cut.
+ * @param local scratch space of one entry per path of self.
+ * @param source filled with the index in self of each path appended, by its
+ * index in path_list, or NULL.
+ * @param kinematics the machine model.
+ * @param current the end the head is at, moved to where it finishes.
+ */
+static bool path_list_order(path_list_t *self, path_list_t *path_list, const size_t *paths, size_t count,
+                            const size_t *parent, size_t *remaining, size_t *local, size_t *source,
+                            kinematics_t *kinematics, struct path_list_end *current)
+{
+	size_t entries = 0;
+	for (size_t path = 0; path < count; path += 1)
+		entries += path_list_count_entries(self, paths[path]);
+
+	// Entries first_entry[k] up to first_entry[k + 1] belong to paths[k]
+	vector_list_t *ends = vector_list_create();
+	size_t *first_entry = calloc(count + 1, sizeof(size_t));
+	size_t *owner = calloc(entries + 1, sizeof(size_t));
+	bool *held = calloc(count + 1, sizeof(bool));
+	vector_grid_t *grid = NULL;
+	if (ends == NULL || first_entry == NULL || owner == NULL || held == NULL)
+		goto path_list_order_fail;
+
+	for (size_t path = 0; path < count; path += 1) {
+		local[paths[path]] = path;
+		first_entry[path] = ends->length;
+		if (!path_list_add_entries(self, paths[path], ends, owner, path))
+			goto path_list_order_fail;
+	}
+	first_entry[count] = ends->length;
+
+	grid = vector_grid_create(ends);
+	if (grid == NULL)
+		goto path_list_order_fail;
+
+	size_t candidates[PATH_LIST_ORDER_CANDIDATES];
+	size_t found;
+	while ((found = vector_grid_nearest(grid, &current->point, PATH_LIST_ORDER_CANDIDATES, candidates)) > 0) {
+		size_t entry = candidates[0];
+		bool reverse = false;
+		double best_cost = 0.0;
+		for (size_t candidate = 0; candidate < found; candidate += 1) {
+			size_t path = owner[candidates[candidate]];
+			bool candidate_reverse;
+			double cost = path_list_entry_link(self, paths[path], candidates[candidate] - first_entry[path], kinematics,
+			                                   current, &candidate_reverse);
+			if (candidate == 0 || cost < best_cost) {
+				entry = candidates[candidate];
+				reverse = candidate_reverse;
+				best_cost = cost;
+			}
+		}
+
+		size_t path = owner[entry];
+		for (size_t other = first_entry[path]; other < first_entry[path + 1]; other += 1)
+			vector_grid_remove(grid, other);
+
+		size_t index = paths[path];
+		if (parent != NULL && remaining[index] > 0) {
+			// Cut once everything inside it has been
+			held[path] = true;
+			continue;
+		}
+
+		if (path_list_append_entered(path_list, self, index, entry - first_entry[path], reverse) == NULL)
+			goto path_list_order_fail;
+		*current = path_list_exit(path_list, path_list->length - 1);
+		if (source != NULL)
+			source[path_list->length - 1] = index;
+
+		// Cut any held paths this was the last one inside of
+		while (parent != NULL && parent[index] != SIZE_MAX) {
+			index = parent[index];
+			remaining[index] -= 1;
+			if (remaining[index] > 0 || !held[local[index]])
+				break;
+
+			held[local[index]] = false;
+			size_t vertex = path_list_nearest_vertex(self, index, &current->point);
+			path_list_entry_link(self, index, vertex, kinematics, current, &reverse);
+			if (path_list_append_entered(path_list, self, index, vertex, reverse) == NULL)
+				goto path_list_order_fail;
+			*current = path_list_exit(path_list, path_list->length - 1);
+			if (source != NULL)
+				source[path_list->length - 1] = index;
+		}
+	}
+
+	// The search only comes up empty early when the grid cannot be rebuilt
+	if (grid->live > 0)
+		goto path_list_order_fail;
+
+	vector_grid_destroy(grid);
+	vector_list_destroy(ends);
+	free(first_entry);
+	free(owner);
+	free(held);
+
+	return true;
+
+ path_list_order_fail:
+	vector_grid_destroy(grid);
+	vector_list_destroy(ends);
+	free(first_entry);
+	free(owner);
+	free(held);
+
+	return false;
+}
+
+/**
+ * Time the machine model estimates for moving the head onto the quickest
+ * path to reach, the first move path_list_optimize makes from there.
+ *
+ * @param kinematics the machine model.
+ * @param origin where the head is.
+ *
+ * @return The time, INFINITY for an empty list.
+ */
+double path_list_entry_time(path_list_t *self, kinematics_t *kinematics, const point_t *origin)
+{
+	struct path_list_end current = { *origin, *origin };
+	double best = INFINITY;
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		size_t vertices = path_list_closed(self, index) ? path_list_points(self, index) - 1 : 1;
+		for (size_t vertex = 0; vertex < vertices; vertex += 1) {
+			bool reverse;
+			double time = path_list_entry_link(self, index, vertex, kinematics, &current, &reverse);
+			if (time < best)
+				best = time;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Order the paths to minimize transit, greedily cutting next whichever of
+ * the paths with an end nearest the head the machine model estimates is
+ * quickest to reach, from whichever end or point of it that is, and in
+ * whichever direction turns least onto it.
+ *
+ * @param self the paths, left untouched.
+ * @param kinematics the machine model.
+ * @param origin where the head starts.
+ *
+ * @return A new path list, NULL on allocation failure.
+ */
+path_list_t *path_list_optimize(path_list_t *self, kinematics_t *kinematics, const point_t *origin)
+{
+	path_list_t *path_list = path_list_create();
+	size_t *paths = calloc(self->length + 1, sizeof(size_t));
+	size_t *local = calloc(self->length + 1, sizeof(size_t));
+	if (path_list == NULL || paths == NULL || local == NULL) {
+		free(paths);
+		free(local);
+		return path_list_destroy(path_list);
+	}
+
+	for (size_t index = 0; index < self->length; index += 1)
+		paths[index] = index;
+
+	struct path_list_end current = { *origin, *origin };
+	if (!path_list_order(self, path_list, paths, self->length, NULL, NULL, local, NULL, kinematics, &current))
+		path_list = path_list_destroy(path_list);
+
+	free(paths);
+	free(local);
+
+	return path_list;
+}
+
+/*
+ * Bounding box and area of a closed path, for nesting.
+ */
+struct path_list_contour {
+	size_t index;
+	double area;
+	int32_t x_min;
+	int32_t y_min;
+	int32_t x_max;
+	int32_t y_max;
+};
+
+static int path_list_contour_compare(const void *a, const void *b)
+{
+	const struct path_list_contour *self = a;
+	const struct path_list_contour *other = b;
+
+	if (self->area != other->area)
+		return (self->area < other->area) ? -1 : 1;
+	return (self->index < other->index) ? -1 : (self->index > other->index);
+}
+
+/*
+ * Even-odd test of a point against a closed path.
+ */
+static bool path_list_contains(path_list_t *self, size_t index, double px, double py)
+{
+	bool inside = false;
+	for (size_t point = self->offsets[index] + 1; point < self->offsets[index + 1]; point += 1) {
+		double ax = self->x[point - 1], ay = self->y[point - 1];
+		double bx = self->x[point], by = self->y[point];
+		if ((ay > py) != (by > py) && px < ax + (py - ay) * (bx - ax) / (by - ay))
+			inside = !inside;
+	}
+	return inside;
+}
+
+/*
+ * Point a path is tested for lying inside others by, the middle of its first
+ * segment so that it is off any contour it only touches at a vertex.
+ */
+static void path_list_probe(path_list_t *self, size_t index, double *px, double *py)
+{
+	size_t first = self->offsets[index];
+	size_t second = (first + 1 < self->offsets[index + 1]) ? first + 1 : first;
+	*px = ((double)self->x[first] + self->x[second]) / 2.0;
+	*py = ((double)self->y[first] + self->y[second]) / 2.0;
+}
+
+/*
+ * Find the closed path each path lies directly inside, the smallest one
+ * containing it, SIZE_MAX for none. Closed paths can only lie inside larger
+ * ones, so the nesting has no cycles.
+ */
+static bool path_list_nesting(path_list_t *self, size_t *parent)
+{
+	for (size_t index = 0; index < self->length; index += 1)
+		parent[index] = SIZE_MAX;
+
+	size_t contours_count = 0;
+	for (size_t index = 0; index < self->length; index += 1)
+		contours_count += path_list_closed(self, index) ? 1 : 0;
+	if (contours_count == 0)
+		return true;
+
+	struct path_list_contour *contours = calloc(contours_count, sizeof(struct path_list_contour));
+	double *area = calloc(self->length + 1, sizeof(double));
+	if (contours == NULL || area == NULL) {
+		free(contours);
+		free(area);
+		return false;
+	}
+
+	int64_t x_min = INT64_MAX, y_min = INT64_MAX;
+	int64_t x_max = INT64_MIN, y_max = INT64_MIN;
+
+	size_t contour = 0;
+	for (size_t index = 0; index < self->length; index += 1) {
+		if (!path_list_closed(self, index))
+			continue;
+
+		struct path_list_contour *c = &contours[contour++];
+		c->index = index;
+		c->x_min = c->y_min = INT32_MAX;
+		c->x_max = c->y_max = INT32_MIN;
+		for (size_t point = self->offsets[index]; point < self->offsets[index + 1]; point += 1) {
+			c->x_min = (self->x[point] < c->x_min) ? self->x[point] : c->x_min;
+			c->y_min = (self->y[point] < c->y_min) ? self->y[point] : c->y_min;
+			c->x_max = (self->x[point] > c->x_max) ? self->x[point] : c->x_max;
+			c->y_max = (self->y[point] > c->y_max) ? self->y[point] : c->y_max;
+			if (point > self->offsets[index])
+				c->area += (double)self->x[point - 1] * self->y[point] - (double)self->x[point] * self->y[point - 1];
+		}
+		c->area = fabs(c->area) / 2.0;
+		area[index] = c->area;
+
+		x_min = (c->x_min < x_min) ? c->x_min : x_min;
+		y_min = (c->y_min < y_min) ? c->y_min : y_min;
+		x_max = (c->x_max > x_max) ? c->x_max : x_max;
+		y_max = (c->y_max > y_max) ? c->y_max : y_max;
+	}
+
+	// Smallest first, so the first contour found around a point is its parent
+	qsort(contours, contours_count, sizeof(struct path_list_contour), path_list_contour_compare);
+
+	// Bucket the contours into every cell of a grid their box overlaps
+	int64_t width = x_max - x_min + 1;
+	int64_t height = y_max - y_min + 1;
+	int64_t cell_size = (int64_t)sqrt((double)width * (double)height / (double)contours_count);
+	if (cell_size < 1)
+		cell_size = 1;
+	while ((width / cell_size + 1) * (height / cell_size + 1) > (int64_t)(4 * contours_count + 16))
+		cell_size *= 2;
+	int64_t columns = width / cell_size + 1;
+	int64_t rows = height / cell_size + 1;
+
+	size_t *cell_start = calloc(columns * rows + 1, sizeof(size_t));
+	if (cell_start == NULL) {
+		free(contours);
+		free(area);
+		return false;
+	}
+
+	for (size_t c = 0; c < contours_count; c += 1) {
+		for (int64_t row = (contours[c].y_min - y_min) / cell_size; row <= (contours[c].y_max - y_min) / cell_size; row += 1)
+			for (int64_t column = (contours[c].x_min - x_min) / cell_size; column <= (contours[c].x_max - x_min) / cell_size; column += 1)
+				cell_start[row * columns + column + 1] += 1;
+	}
+	for (int64_t cell = 0; cell < columns * rows; cell += 1)
+		cell_start[cell + 1] += cell_start[cell];
+
+	size_t *cell_fill = calloc(columns * rows + 1, sizeof(size_t));
+	size_t *cell_contours = calloc(cell_start[columns * rows] + 1, sizeof(size_t));
+	if (cell_fill == NULL || cell_contours == NULL) {
+		free(cell_fill);
+		free(cell_contours);
+		free(cell_start);
+		free(contours);
+		free(area);
+		return false;
+	}
+
+	for (size_t c = 0; c < contours_count; c += 1) {
+		for (int64_t row = (contours[c].y_min - y_min) / cell_size; row <= (contours[c].y_max - y_min) / cell_size; row += 1) {
+			for (int64_t column = (contours[c].x_min - x_min) / cell_size; column <= (contours[c].x_max - x_min) / cell_size; column += 1) {
+				int64_t cell = row * columns + column;
+				cell_contours[cell_start[cell] + cell_fill[cell]] = c;
+				cell_fill[cell] += 1;
+			}
+		}
+	}
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		double px, py;
+		path_list_probe(self, index, &px, &py);
+		if (px < x_min || py < y_min || px > x_max || py > y_max)
+			continue;
+
+		int64_t cell = ((int64_t)py - y_min) / cell_size * columns + ((int64_t)px - x_min) / cell_size;
+		bool closed = path_list_closed(self, index);
+		for (size_t position = cell_start[cell]; position < cell_start[cell + 1]; position += 1) {
+			struct path_list_contour *c = &contours[cell_contours[position]];
+			if (c->index == index || (closed && c->area <= area[index]))
+				continue;
+			if (px < c->x_min || py < c->y_min || px > c->x_max || py > c->y_max)
+				continue;
+			if (path_list_contains(self, c->index, px, py)) {
+				parent[index] = c->index;
+				break;
+			}
+		}
+	}
+
+	free(cell_fill);
+	free(cell_contours);
+	free(cell_start);
+	free(contours);
+	free(area);
+
+	return true;
+}
+
+static size_t path_list_find(size_t *set, size_t index)
+{
+	while (set[index] != index) {
+		set[index] = set[set[index]];
+		index = set[index];
+	}
+	return index;
+}
+
+static void path_list_union(size_t *set, size_t a, size_t b)
+{
+	a = path_list_find(set, a);
+	b = path_list_find(set, b);
+	if (a != b)
+		set[(a < b) ? b : a] = (a < b) ? a : b;
+}
+
+/*
+ * Points of the paths sorted by position, so that paths sharing a point
+ * sort next to each other.
+ */
+struct path_list_vertex {
+	int32_t x;
+	int32_t y;
+	size_t index;
+};
+
+static int path_list_vertex_compare(const void *a, const void *b)
+{
+	const struct path_list_vertex *self = a;
+	const struct path_list_vertex *other = b;
+
+	if (self->x != other->x)
+		return (self->x < other->x) ? -1 : 1;
+	if (self->y != other->y)
+		return (self->y < other->y) ? -1 : 1;
+	return (self->index < other->index) ? -1 : (self->index > other->index);
+}
+
+/*
+ * Group the paths into parts, each the paths touching one another and
+ * everything lying inside them.
+ *
+ * @param set filled with a union find forest, paths of a part share a root.
+ */
+static bool path_list_parts(path_list_t *self, const size_t *parent, size_t *set)
+{
+	for (size_t index = 0; index < self->length; index += 1)
+		set[index] = index;
+
+	struct path_list_vertex *vertices = calloc(self->point_count + 1, sizeof(struct path_list_vertex));
+	if (vertices == NULL)
+		return false;
+
+	for (size_t index = 0; index < self->length; index += 1)
+		for (size_t point = self->offsets[index]; point < self->offsets[index + 1]; point += 1)
+			vertices[point] = (struct path_list_vertex){ self->x[point], self->y[point], index };
+	qsort(vertices, self->point_count, sizeof(struct path_list_vertex), path_list_vertex_compare);
+
+	for (size_t point = 1; point < self->point_count; point += 1) {
+		if (vertices[point].x == vertices[point - 1].x && vertices[point].y == vertices[point - 1].y)
+			path_list_union(set, vertices[point].index, vertices[point - 1].index);
+	}
+	free(vertices);
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		if (parent[index] != SIZE_MAX)
+			path_list_union(set, index, parent[index]);
+	}
+
+	return true;
+}
+
+/**
+ * Order the paths part by part. A part is a group of paths touching one
+ * another, together with everything lying inside them, as a nested layout
+ * cuts out one piece. Parts are toured greedily by their nearest end, and the
+ * paths of each part are ordered greedily among themselves before moving on.
+ *
+ * The result marks each path with a group, path_list_improve only reorders
+ * paths within one group so that the parts stay whole.
+ *
+ * @param self the paths, left untouched.
+ * @param kinematics the machine model.
+ * @param inner_first whether every closed path has to be cut after all the
+ * paths inside it, so that nothing drops out of the sheet before it is cut.
+ * @param origin where the head starts.
+ *
+ * @return A new path list, NULL on allocation failure.
+ */
+path_list_t *path_list_optimize_parts(path_list_t *self, kinematics_t *kinematics, bool inner_first,
+                                      const point_t *origin)
+{
+	size_t length = self->length;
+
+	path_list_t *path_list = path_list_create();
+	size_t *parent = calloc(length + 1, sizeof(size_t));
+	size_t *set = calloc(length + 1, sizeof(size_t));
+	size_t *remaining = calloc(length + 1, sizeof(size_t));
+	size_t *local = calloc(length + 1, sizeof(size_t));
+	size_t *part_start = calloc(length + 2, sizeof(size_t));
+	size_t *part_paths = calloc(length + 1, sizeof(size_t));
+	size_t *part_of = calloc(length + 1, sizeof(size_t));
+	size_t *first_entry = calloc(length + 1, sizeof(size_t));
+	size_t *source = calloc(length + 1, sizeof(size_t));
+	bool *nests = calloc(length + 1, sizeof(bool));
+	size_t *owner = NULL;
+	vector_list_t *ends = vector_list_create();
+	vector_grid_t *grid = NULL;
+	if (path_list == NULL || parent == NULL || set == NULL || remaining == NULL || local == NULL ||
+	    part_start == NULL || part_paths == NULL || part_of == NULL || first_entry == NULL || source == NULL ||
+	    nests == NULL || ends == NULL)
+		goto path_list_optimize_parts_fail;
+
+	if (!path_list_nesting(self, parent) || !path_list_parts(self, parent, set))
+		goto path_list_optimize_parts_fail;
+
+	for (size_t index = 0; index < length; index += 1) {
+		if (parent[index] != SIZE_MAX) {
+			remaining[parent[index]] += 1;
+			nests[parent[index]] = true;
+		}
+	}
+
+	// Number the parts by their root, then list the paths of each in order
+	size_t parts = 0;
+	for (size_t index = 0; index < length; index += 1) {
+		if (path_list_find(set, index) == index)
+			part_of[index] = parts++;
+	}
+	for (size_t index = 0; index < length; index += 1) {
+		part_of[index] = part_of[path_list_find(set, index)];
+		part_start[part_of[index] + 1] += 1;
+	}
+	for (size_t part = 0; part < parts; part += 1)
+		part_start[part + 1] += part_start[part];
+	for (size_t index = 0; index < length; index += 1)
+		part_paths[part_start[part_of[index]] + local[part_of[index]]++] = index;
+
+	// Tour the parts by the ends of all their paths
+	size_t entries = 0;
+	for (size_t index = 0; index < length; index += 1)
+		entries += path_list_count_entries(self, index);
+	owner = calloc(entries + 1, sizeof(size_t));
+	if (owner == NULL)
+		goto path_list_optimize_parts_fail;
+
+	for (size_t index = 0; index < length; index += 1) {
+		first_entry[index] = ends->length;
+		if (!path_list_add_entries(self, index, ends, owner, part_of[index]))
+			goto path_list_optimize_parts_fail;
+	}
+	first_entry[length] = ends->length;
+
+	grid = vector_grid_create(ends);
+	if (grid == NULL)
+		goto path_list_optimize_parts_fail;
+
+	/* Paths with others inside are the barriers between groups when cutting
+	 * inner first, the paths between two of them can go in any order.
+	 */
+	size_t *group = calloc(length + 1, sizeof(size_t));
+	if (group == NULL)
+		goto path_list_optimize_parts_fail;
+	path_list->group = group;
+
+	struct path_list_end current = { *origin, *origin };
+	size_t groups = 0;
+
+	size_t entry;
+	bool reverse;
+	while (vector_grid_take_closest(grid, &current.point, &entry, &reverse)) {
+		size_t part = owner[entry];
+		for (size_t position = part_start[part]; position < part_start[part + 1]; position += 1) {
+			size_t index = part_paths[position];
+			for (size_t other = first_entry[index]; other < first_entry[index + 1]; other += 1)
+				vector_grid_remove(grid, other);
+		}
+
+		size_t first = path_list->length;
+		if (!path_list_order(self, path_list, &part_paths[part_start[part]], part_start[part + 1] - part_start[part],
+		                     inner_first ? parent : NULL, remaining, local, source, kinematics, &current))
+			goto path_list_optimize_parts_fail;
+
+		for (size_t index = first; index < path_list->length; index += 1) {
+			bool barrier = inner_first && nests[source[index]];
+			if (index == first || barrier || (inner_first && nests[source[index - 1]]))
+				groups += 1;
+			group[index] = groups;
+		}
+	}
+
+	vector_grid_destroy(grid);
+	vector_list_destroy(ends);
+	free(parent);
+	free(set);
+	free(remaining);
+	free(local);
+	free(part_start);
+	free(part_paths);
+	free(part_of);
+	free(first_entry);
+	free(source);
+	free(nests);
+	free(owner);
+
+	return path_list;
+
+ path_list_optimize_parts_fail:
+	vector_grid_destroy(grid);
+	vector_list_destroy(ends);
+	free(parent);
+	free(set);
+	free(remaining);
+	free(local);
+	free(part_start);
+	free(part_paths);
+	free(part_of);
+	free(first_entry);
+	free(source);
+	free(nests);
+	free(owner);
+
+	return path_list_destroy(path_list);
+}
+
+/*
+ * Rotate a closed path in place to start at a vertex, going round it
+ * forwards or backwards.
+ */
+static bool path_list_rotate_path(path_list_t *self, size_t index, size_t vertex, bool reverse)
+{
+	size_t first = self->offsets[index];
+	size_t count = path_list_points(self, index) - 1;
+
+	int32_t *x = calloc(count + 1, sizeof(int32_t));
+	int32_t *y = calloc(count + 1, sizeof(int32_t));
+	if (x == NULL || y == NULL) {
+		free(x);
+		free(y);
+		return false;
+	}
+
+	for (size_t step = 0; step <= count; step += 1) {
+		size_t source = first + path_list_loop_point(count, vertex, step, reverse);
+		x[step] = self->x[source];
+		y[step] = self->y[source];
+	}
+
+	for (size_t step = 0; step <= count; step += 1) {
+		self->x[first + step] = x[step];
+		self->y[first + step] = y[step];
+	}
+
+	free(x);
+	free(y);
+
+	return true;
+}
+
+/**
+ * Start each closed path at the point, and go round it in the direction,
+ * which makes the moves onto and off it cheapest, given the paths either
+ * side of it.
+ *
+ * @param self the ordered paths, rotated in place.
+ * @param kinematics the machine model.
+ * @param origin where the head starts.
+ * @param keep_last whether the last path has to end where it does, as
+ * something else starts from there.
+ *
+ * @return The list, NULL on allocation failure.
+ */
+path_list_t *path_list_rotate(path_list_t *self, kinematics_t *kinematics, const point_t *origin, bool keep_last)
+{
+	struct path_list_end before = { *origin, *origin };
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		if (path_list_closed(self, index) && !(keep_last && index + 1 == self->length)) {
+			bool has_after = index + 1 < self->length;
+			struct path_list_end after = has_after ? path_list_entry(self, index + 1) : before;
+
+			size_t count = path_list_points(self, index) - 1;
+			size_t best_vertex = 0;
+			bool best_reverse = false;
+			double best_cost = 0.0;
+
+			for (size_t vertex = 0; vertex < count; vertex += 1) {
+				for (int direction = 0; direction < 2; direction += 1) {
+					bool reverse = (direction == 1);
+					struct path_list_end entry = path_list_loop_entry(self, index, vertex, reverse);
+					struct path_list_end exit = path_list_loop_exit(self, index, vertex, reverse);
+
+					double cost = path_list_link(kinematics, &before, &entry);
+					if (has_after)
+						cost += path_list_link(kinematics, &exit, &after);
+
+					if ((vertex == 0 && direction == 0) || cost < best_cost) {
+						best_vertex = vertex;
+						best_reverse = reverse;
+						best_cost = cost;
+					}
+				}
+			}
+
+			if ((best_vertex != 0 || best_reverse) && !path_list_rotate_path(self, index, best_vertex, best_reverse))
+				return NULL;
+		}
+
+		before = path_list_exit(self, index);
+	}
+
+	return self;
+}
+
+/*
+ * Order the paths are cut in while it is being improved. Entry and exit are
+ * the ends the head arrives at and leaves from at each position.
+ */
+struct path_list_tour {
+	size_t length;
+	size_t *path;
+	size_t *position;
+	bool *reverse;
+	struct path_list_end *entry;
+	struct path_list_end *exit;
+
+	// Group of each position, which moves leave in place, or NULL
+	const size_t *group;
+
+	// Where the head is before the first position
+	struct path_list_end origin;
+
+	// Where the head goes after the last position, if it is held
+	bool finished;
+	struct path_list_end finish;
+
+	kinematics_t *kinematics;
+};
+
+static double path_list_tour_link(struct path_list_tour *tour, const struct path_list_end *from, const struct path_list_end *to)
+{
+	return path_list_link(tour->kinematics, from, to);
+}
+
+/*
+ * The end the head is at before cutting a position, the origin for the
+ * first.
+ */
+static struct path_list_end path_list_tour_before(struct path_list_tour *tour, size_t position)
+{
+	return (position == 0) ? tour->origin : tour->exit[position - 1];
+}
+
+/*
+ * The end the head goes to for a position, the finish past the last one, or
+ * NULL if there is none.
+ */
+static const struct path_list_end *path_list_tour_next(struct path_list_tour *tour, size_t position)
+{
+	if (position < tour->length)
+		return &tour->entry[position];
+	return tour->finished ? &tour->finish : NULL;
+}
+
+/*
+ * Cost of going from an end to a position, nothing past the last one unless
+ * the finish is held.
+ */
+static double path_list_tour_transit(struct path_list_tour *tour, const struct path_list_end *end, size_t position)
+{
+	const struct path_list_end *next = path_list_tour_next(tour, position);
+	return (next != NULL) ? path_list_tour_link(tour, end, next) : 0.0;
+}
+
+static double path_list_tour_cost(struct path_list_tour *tour)
+{
+	double cost = 0.0;
+	for (size_t position = 0; position <= tour->length; position += 1) {
+		struct path_list_end before = path_list_tour_before(tour, position);
+		cost += path_list_tour_transit(tour, &before, position);
+	}
+	return cost;
+}
+
+static double path_list_tour_length(struct path_list_tour *tour)
+{
+	double length = 0.0;
+	for (size_t position = 0; position <= tour->length; position += 1) {
+		const struct path_list_end *next = path_list_tour_next(tour, position);
+		if (next == NULL)
+			break;
+		struct path_list_end before = path_list_tour_before(tour, position);
+		length += path_list_distance(&before.point, &next->point);
+	}
+	return length;
+}
+
+/*
+ * Cut positions first to last in the opposite order, and each of their
+ * paths backwards.
+ */
+static void path_list_tour_reverse(struct path_list_tour *tour, size_t first, size_t last)
+{
+	for (; first <= last; first += 1, last -= 1) {
+		size_t path = tour->path[first];
+		bool reverse = tour->reverse[first];
+		struct path_list_end entry = tour->entry[first];
+		struct path_list_end exit = tour->exit[first];
+
+		tour->path[first] = tour->path[last];
+		tour->reverse[first] = !tour->reverse[last];
+		tour->entry[first] = tour->exit[last];
+		tour->exit[first] = tour->entry[last];
+		tour->position[tour->path[first]] = first;
+
+		tour->path[last] = path;
+		tour->reverse[last] = !reverse;
+		tour->entry[last] = exit;
+		tour->exit[last] = entry;
+		tour->position[path] = last;
+
+		if (last == 0)
+			break;
+	}
+}
+
+/*
+ * 2-opt move, reverse positions first to last if that shortens the tour.
+ */
+static bool path_list_tour_try_reverse(struct path_list_tour *tour, size_t first, size_t last)
+{
+	if (last - first >= PATH_LIST_IMPROVE_SPAN)
+		return false;
+	if (tour->group != NULL && tour->group[first] != tour->group[last])
+		return false;
+
+	struct path_list_end before = path_list_tour_before(tour, first);
+
+	double removed = path_list_tour_link(tour, &before, &tour->entry[first]) +
+		path_list_tour_transit(tour, &tour->exit[last], last + 1);
+	double added = path_list_tour_link(tour, &before, &tour->exit[last]) +
+		path_list_tour_transit(tour, &tour->entry[first], last + 1);
+
+	if (added - removed > -PATH_LIST_IMPROVE_EPSILON)
+		return false;
+
+	path_list_tour_reverse(tour, first, last);
+	return true;
+}
+
+/*
+ * Or-opt move, take positions first to last out and cut them just before
+ * position at instead, backwards if reverse is set, if that shortens the
+ * tour.
+ */
+static bool path_list_tour_try_move(struct path_list_tour *tour, size_t first, size_t last, size_t at, bool reverse)
+{
+	if (at >= first && at <= last + 1)
+		return false;
+	if ((at > last && at - first > PATH_LIST_IMPROVE_SPAN) || (at < first && last - at > PATH_LIST_IMPROVE_SPAN))
+		return false;
+	if (tour->group != NULL) {
+		size_t group = tour->group[first];
+		if (tour->group[last] != group ||
+		    !((at < tour->length && tour->group[at] == group) || (at > 0 && tour->group[at - 1] == group)))
+			return false;
+	}
+
+	struct path_list_end before = path_list_tour_before(tour, first);
+	struct path_list_end *in = reverse ? &tour->exit[last] : &tour->entry[first];
+	struct path_list_end *out = reverse ? &tour->entry[first] : &tour->exit[last];
+
+	double removed = path_list_tour_link(tour, &before, &tour->entry[first]) +
+		path_list_tour_transit(tour, &tour->exit[last], last + 1) -
+		path_list_tour_transit(tour, &before, last + 1);
+
+	struct path_list_end after = path_list_tour_before(tour, at);
+	double added = path_list_tour_link(tour, &after, in) +
+		path_list_tour_transit(tour, out, at) -
+		path_list_tour_transit(tour, &after, at);
+
+	if (added - removed > -PATH_LIST_IMPROVE_EPSILON)
+		return false;
+
+	// Moves are made of reversals, reversing a run twice restores it
+	size_t count = last - first + 1;
+	if (at > last) {
+		if (!reverse)
+			path_list_tour_reverse(tour, first, last);
+		path_list_tour_reverse(tour, last + 1, at - 1);
+		path_list_tour_reverse(tour, first, at - 1);
+	}
+	else {
+		path_list_tour_reverse(tour, at, last);
+		if (!reverse)
+			path_list_tour_reverse(tour, at, at + count - 1);
+		path_list_tour_reverse(tour, at + count, last);
+	}
+
+	return true;
+}
+
+/*
+ * Endpoint ids of the path at a position, twice the path plus one for its
+ * last point, as the neighbour lists are indexed.
+ */
+static size_t path_list_tour_entry_endpoint(struct path_list_tour *tour, size_t position)
+{
+	return 2 * tour->path[position] + (tour->reverse[position] ? 1 : 0);
+}
+
+static size_t path_list_tour_exit_endpoint(struct path_list_tour *tour, size_t position)
+{
+	return 2 * tour->path[position] + (tour->reverse[position] ? 0 : 1);
+}
+
+/*
+ * Try every move joining a position to the paths nearest its ends.
+ */
+static bool path_list_tour_improve_position(struct path_list_tour *tour, size_t position,
+                                            const size_t *neighbours, const size_t *neighbour_counts)
+{
+	if (path_list_tour_try_reverse(tour, position, position))
+		return true;
+
+	size_t exit = path_list_tour_exit_endpoint(tour, position);
+	for (size_t neighbour = 0; neighbour < neighbour_counts[exit]; neighbour += 1) {
+		size_t other = tour->position[neighbours[exit * PATH_LIST_IMPROVE_NEIGHBOURS + neighbour]];
+		if (other > position && path_list_tour_try_reverse(tour, position + 1, other))
+			return true;
+	}
+
+	size_t entry = path_list_tour_entry_endpoint(tour, position);
+	for (size_t neighbour = 0; neighbour < neighbour_counts[entry]; neighbour += 1) {
+		size_t other = tour->position[neighbours[entry * PATH_LIST_IMPROVE_NEIGHBOURS + neighbour]];
+		if (other < position && path_list_tour_try_reverse(tour, other, position - 1))
+			return true;
+	}
+
+	for (size_t count = 1; count <= PATH_LIST_IMPROVE_SEGMENT && position + count <= tour->length; count += 1) {
+		size_t last = position + count - 1;
+
+		entry = path_list_tour_entry_endpoint(tour, position);
+		for (size_t neighbour = 0; neighbour < neighbour_counts[entry]; neighbour += 1) {
+			size_t other = tour->position[neighbours[entry * PATH_LIST_IMPROVE_NEIGHBOURS + neighbour]];
+			if (path_list_tour_try_move(tour, position, last, other + 1, false) ||
+			    path_list_tour_try_move(tour, position, last, other, true))
+				return true;
+		}
+
+		exit = path_list_tour_exit_endpoint(tour, last);
+		for (size_t neighbour = 0; neighbour < neighbour_counts[exit]; neighbour += 1) {
+			size_t other = tour->position[neighbours[exit * PATH_LIST_IMPROVE_NEIGHBOURS + neighbour]];
+			if (path_list_tour_try_move(tour, position, last, other, false) ||
+			    path_list_tour_try_move(tour, position, last, other + 1, true))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static void path_list_tour_free(struct path_list_tour *tour)
+{
+	free(tour->path);
+	free(tour->position);
+	free(tour->reverse);
+	free(tour->entry);
+	free(tour->exit);
+}
+
+/**
+ * Find, for each end of each of the first paths, the paths among them with
+ * an end nearest it.
+ *
+ * @param length the number of paths looked at, those after are left out.
+ * @param neighbours filled with up to PATH_LIST_IMPROVE_NEIGHBOURS paths per
+ * endpoint id.
+ * @param neighbour_counts filled with the number found per endpoint id.
+ */
+static bool path_list_neighbours(path_list_t *self, size_t length, size_t *neighbours, size_t *neighbour_counts)
+{
+	vector_list_t *ends = path_list_ends(self);
+	if (ends == NULL)
+		return false;
+
+	vector_grid_t *grid = vector_grid_create(ends);
+	if (grid == NULL) {
+		vector_list_destroy(ends);
+		return false;
+	}
+
+	size_t found[PATH_LIST_IMPROVE_NEIGHBOURS + 1];
+	for (size_t endpoint = 0; endpoint < 2 * length; endpoint += 1) {
+		size_t path = endpoint >> 1;
+		point_t point = (endpoint & 1) ?
+			(point_t){ ends->end_x[path], ends->end_y[path] } :
+			(point_t){ ends->start_x[path], ends->start_y[path] };
+
+		size_t count = vector_grid_nearest(grid, &point, PATH_LIST_IMPROVE_NEIGHBOURS + 1, found);
+
+		neighbour_counts[endpoint] = 0;
+		for (size_t index = 0; index < count; index += 1) {
+			if (found[index] == path || found[index] >= length || neighbour_counts[endpoint] == PATH_LIST_IMPROVE_NEIGHBOURS)
+				continue;
+			neighbours[endpoint * PATH_LIST_IMPROVE_NEIGHBOURS + neighbour_counts[endpoint]] = found[index];
+			neighbour_counts[endpoint] += 1;
+		}
+	}
+
+	vector_grid_destroy(grid);
+	vector_list_destroy(ends);
+
+	return true;
+}
+
+static bool path_list_improve_expired(const struct timespec *deadline)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/**
+ * Shorten the transit of an ordered list with 2-opt and Or-opt moves between
+ * nearby paths, until no move helps or a bound is reached. Whatever has been
+ * improved by then is kept.
+ *
+ * @param self the ordered paths, left untouched. Paths marked with a group
+ * are only moved within it.
+ * @param sweeps passes over the whole tour to make at most, 0 for no limit.
+ * The result only depends on the input when this alone bounds the work.
+ * @param budget milliseconds to spend at most, 0 for no limit.
+ * @param kinematics the machine model whose estimated time is minimized.
+ * @param origin where the head starts.
+ * @param keep_last whether the last path has to stay last and end where it
+ * does, as something else starts from there.
+ * @param stream where the before and after transit is reported.
+ *
+ * @return A new path list, NULL on allocation failure.
+ */
+path_list_t *path_list_improve(path_list_t *self, uint32_t sweeps, uint32_t budget, kinematics_t *kinematics,
+                               const point_t *origin, bool keep_last, FILE *stream)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += budget / 1000;
+	deadline.tv_nsec += (long)(budget % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec += 1;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	// A kept last path is left out of the tour, which finishes by going to it
+	bool finished = keep_last && self->length > 0;
+	size_t length = finished ? self->length - 1 : self->length;
+	struct path_list_tour tour = {
+		.length = length,
+		.path = calloc(length + 1, sizeof(size_t)),
+		.position = calloc(length + 1, sizeof(size_t)),
+		.reverse = calloc(length + 1, sizeof(bool)),
+		.entry = calloc(length + 1, sizeof(struct path_list_end)),
+		.exit = calloc(length + 1, sizeof(struct path_list_end)),
+		.group = self->group,
+		.origin = { *origin, *origin },
+		.finished = finished,
+		.kinematics = kinematics,
+	};
+	if (finished)
+		tour.finish = path_list_entry(self, length);
+
+	size_t *neighbours = calloc(2 * length * PATH_LIST_IMPROVE_NEIGHBOURS + 1, sizeof(size_t));
+	size_t *neighbour_counts = calloc(2 * length + 1, sizeof(size_t));
+	path_list_t *path_list = path_list_create();
+	if (tour.path == NULL || tour.position == NULL || tour.reverse == NULL || tour.entry == NULL ||
+	    tour.exit == NULL || neighbours == NULL || neighbour_counts == NULL || path_list == NULL ||
+	    !path_list_neighbours(self, length, neighbours, neighbour_counts))
+		goto path_list_improve_fail;
+
+	for (size_t position = 0; position < length; position += 1) {
+		tour.path[position] = position;
+		tour.position[position] = position;
+		tour.entry[position] = path_list_entry(self, position);
+		tour.exit[position] = path_list_exit(self, position);
+	}
+
+	double length_before = path_list_tour_length(&tour);
+	double cost_before = path_list_tour_cost(&tour);
+
+	bool improved = true;
+	bool expired = false;
+	uint32_t sweep = 0;
+	while (improved && !expired && (sweeps == 0 || sweep < sweeps)) {
+		improved = false;
+		sweep += 1;
+		for (size_t position = 0; position < length; position += 1) {
+			if (budget > 0 && position % PATH_LIST_IMPROVE_CLOCK_INTERVAL == 0 &&
+			    path_list_improve_expired(&deadline)) {
+				expired = true;
+				break;
+			}
+			if (path_list_tour_improve_position(&tour, position, neighbours, neighbour_counts))
+				improved = true;
+		}
+	}
+
+	double length_after = path_list_tour_length(&tour);
+	fprintf(stream, "Tour: len %"PRId64" est %.2fs improved to len %"PRId64" est %.2fs%s\n",
+	       (int64_t)length_before, cost_before, (int64_t)length_after, path_list_tour_cost(&tour),
+	       expired ? " (time budget spent)" : (improved && sweep == sweeps) ? " (sweeps spent)" : "");
+
+	for (size_t position = 0; position < length; position += 1) {
+		if (path_list_append_path(path_list, self, tour.path[position], tour.reverse[position]) == NULL)
+			goto path_list_improve_fail;
+	}
+
+	if (finished && path_list_append_path(path_list, self, length, false) == NULL)
+		goto path_list_improve_fail;
+
+	free(neighbours);
+	free(neighbour_counts);
+	path_list_tour_free(&tour);
+
+	return path_list;
+
+ path_list_improve_fail:
+	free(neighbours);
+	free(neighbour_counts);
+	path_list_tour_free(&tour);
+
+	return path_list_destroy(path_list);
+}
+
+/*
+ * Squared distance from point p to the segment between points a and b.
+ */
+static double path_list_segment_distance(path_list_t *self, size_t a, size_t b, size_t p)
+{
+	double dx = (double)self->x[b] - self->x[a];
+	double dy = (double)self->y[b] - self->y[a];
+	double px = (double)self->x[p] - self->x[a];
+	double py = (double)self->y[p] - self->y[a];
+
+	double length = dx * dx + dy * dy;
+	double t = (length > 0) ? (px * dx + py * dy) / length : 0;
+	if (t < 0)
+		t = 0;
+	else if (t > 1)
+		t = 1;
+
+	double ex = px - t * dx;
+	double ey = py - t * dy;
+	return ex * ex + ey * ey;
+}
+
+/*
+ * Whether point b can be dropped from a, b, c: repeated, or on the line from a
+ * to c and heading the same way, so a cut from a to c covers the same ground.
+ */
+static bool path_list_collinear(path_list_t *self, size_t a, size_t b, int32_t cx, int32_t cy)
+{
+	int64_t abx = (int64_t)self->x[b] - self->x[a];
+	int64_t aby = (int64_t)self->y[b] - self->y[a];
+	int64_t bcx = (int64_t)cx - self->x[b];
+	int64_t bcy = (int64_t)cy - self->y[b];
+
+	return abx * bcy == aby * bcx && abx * bcx + aby * bcy > 0;
+}
+
+/*
+ * Douglas-Peucker over points first to last of the list, marking those to
+ * keep. An explicit stack stands in for recursion, flattened curves can run
+ * to many thousands of points.
+ */
+static void path_list_douglas_peucker(path_list_t *self, size_t first, size_t last, double tolerance,
+                                      bool *keep, size_t *stack)
+{
+	for (size_t point = first; point <= last; point += 1)
+		keep[point] = false;
+	keep[first] = true;
+	keep[last] = true;
+
+	size_t depth = 0;
+	stack[depth++] = first;
+	stack[depth++] = last;
+
+	while (depth > 0) {
+		size_t b = stack[--depth];
+		size_t a = stack[--depth];
+
+		double worst = tolerance;
+		size_t split = a;
+		for (size_t point = a + 1; point < b; point += 1) {
+			double distance = path_list_segment_distance(self, a, b, point);
+			if (distance > worst) {
+				worst = distance;
+				split = point;
+			}
+		}
+
+		if (split == a)
+			continue;
+
+		keep[split] = true;
+		stack[depth++] = a;
+		stack[depth++] = split;
+		stack[depth++] = split;
+		stack[depth++] = b;
+	}
+}
+
+/**
+ * Drop points that do not change what a path cuts: repeats and points on a
+ * straight run. With a positive tolerance, Douglas-Peucker then drops every
+ * point within tolerance of the simplified path. The first and last point of
+ * each path are always kept so paths still meet where they did.
+ *
+ * @param self the list to simplify in place.
+ * @param tolerance the furthest, in device units, a dropped point may lie from the path, 0 for exact merges only.
+ * @param removed set to the number of points dropped.
+ *
+ * @return The list, NULL if working space could not be allocated.
+ */
+path_list_t *path_list_simplify(path_list_t *self, int32_t tolerance, size_t *removed)
+{
+	bool *keep = calloc(self->point_count + 1, sizeof(bool));
+	size_t *stack = calloc(2 * self->point_count + 2, sizeof(size_t));
+	if (keep == NULL || stack == NULL) {
+		free(keep);
+		free(stack);
+		return NULL;
+	}
+
+	double squared_tolerance = (double)tolerance * tolerance;
+
+	// Points only ever move towards the front, so both passes compact in place
+	size_t out = 0;
+	size_t next = self->offsets[0];
+	for (size_t index = 0; index < self->length; index += 1) {
+		size_t first = next;
+		size_t start = out;
+		next = self->offsets[index + 1];
+
+		for (size_t point = first; point < next; point += 1) {
+			int32_t x = self->x[point];
+			int32_t y = self->y[point];
+			size_t count = out - start;
+
+			if (count >= 1 && self->x[out - 1] == x && self->y[out - 1] == y)
+				continue;
+
+			if (count >= 2 && path_list_collinear(self, out - 2, out - 1, x, y))
+				out -= 1;
+
+			self->x[out] = x;
+			self->y[out] = y;
+			out += 1;
+		}
+
+		// A path of one repeated point still marks the spot once
+		if (out - start == 1) {
+			self->x[out] = self->x[start];
+			self->y[out] = self->y[start];
+			out += 1;
+		}
+
+		if (tolerance > 0 && out - start > 2) {
+			path_list_douglas_peucker(self, start, out - 1, squared_tolerance, keep, stack);
+
+			size_t kept = start;
+			for (size_t point = start; point < out; point += 1) {
+				if (keep[point]) {
+					self->x[kept] = self->x[point];
+					self->y[kept] = self->y[point];
+					kept += 1;
+				}
+			}
+			out = kept;
+		}
+
+		self->offsets[index] = start;
+		self->offsets[index + 1] = out;
+	}
+
+	*removed = self->point_count - out;
+	self->point_count = out;
+
+	free(keep);
+	free(stack);
+
+	return self;
+}
+
+/**
+ * Flatten the paths back into the vectors between their consecutive points,
+ * in order.
+ *
+ * @return A new vector list, NULL on allocation failure.
+ */
+vector_list_t *path_list_to_vector_list(path_list_t *self)
+{
+	vector_list_t *list = vector_list_create();
+	if (list == NULL)
+		return NULL;
+
+	for (size_t index = 0; index < self->length; index += 1) {
+		for (size_t point = self->offsets[index] + 1; point < self->offsets[index + 1]; point += 1) {
+			vector_t vector = {
+				{ self->x[point - 1], self->y[point - 1] },
+				{ self->x[point], self->y[point] },
+			};
+			if (vector_list_append(list, &vector) == NULL)
+				return vector_list_destroy(list);
+		}
+	}
+
+	return list;
+}
@@ -0,0 +1,87 @@
+#ifndef __PDF2LASER_TYPE_PATH_LIST_H__
+#define __PDF2LASER_TYPE_PATH_LIST_H__ 1
+
+#include <stdbool.h>           // for bool
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t, uint32_t
+#include <stdio.h>             // for FILE
+#include "type_kinematics.h"   // for kinematics_t
+#include "type_point.h"        // for point_t
+#include "type_vector_list.h"  // for vector_list_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+// Points, and paths, a list makes room for on first use, doubled as it fills
+#define PATH_LIST_INITIAL_CAPACITY (1024)
+
+// Nearest path ends the greedy order weighs with the machine model at each step
+#define PATH_LIST_ORDER_CANDIDATES (8)
+
+// Nearest paths path_list_improve tries joining each path end to
+#define PATH_LIST_IMPROVE_NEIGHBOURS (8)
+
+// Longest run of paths path_list_improve moves at once
+#define PATH_LIST_IMPROVE_SEGMENT (3)
+
+// Most positions a path_list_improve move shifts, moves cost time in their span
+#define PATH_LIST_IMPROVE_SPAN (25000)
+
+// Smallest saving, in device units, path_list_improve takes a move for
+#define PATH_LIST_IMPROVE_EPSILON (1e-6)
+
+// Positions path_list_improve visits between looks at the clock
+#define PATH_LIST_IMPROVE_CLOCK_INTERVAL (256)
+
+/**
+ * Ordered store of polylines. The points of every path are kept end to end
+ * in one array per coordinate, path i holds the points from offsets[i] up to
+ * offsets[i + 1]. An ordered list may also mark each path with a group, the
+ * paths of one group are only ever reordered among themselves.
+ */
+typedef struct path_list path_list_t;
+struct path_list {
+	int32_t *x;
+	int32_t *y;
+	size_t point_count;
+	size_t point_capacity;
+
+	size_t *offsets;
+	size_t length;
+	size_t capacity;
+
+	size_t *group;
+};
+
+path_list_t *path_list_create(void);
+path_list_t *path_list_destroy(path_list_t *self);
+
+path_list_t *path_list_begin(path_list_t *self);
+path_list_t *path_list_add_point(path_list_t *self, int32_t x, int32_t y);
+path_list_t *path_list_append_path(path_list_t *self, path_list_t *other, size_t index, bool reverse);
+path_list_t *path_list_append_rotated(path_list_t *self, path_list_t *other, size_t index, size_t vertex, bool reverse);
+
+size_t path_list_points(path_list_t *self, size_t index);
+bool path_list_closed(path_list_t *self, size_t index);
+
+path_list_t *path_list_from_vector_list(vector_list_t *list);
+path_list_t *path_list_chain(vector_list_t *list);
+double path_list_entry_time(path_list_t *self, kinematics_t *kinematics, const point_t *origin);
+path_list_t *path_list_optimize(path_list_t *self, kinematics_t *kinematics, const point_t *origin);
+path_list_t *path_list_optimize_parts(path_list_t *self, kinematics_t *kinematics, bool inner_first,
+                                      const point_t *origin);
+path_list_t *path_list_improve(path_list_t *self, uint32_t sweeps, uint32_t budget, kinematics_t *kinematics,
+                               const point_t *origin, bool keep_last, FILE *stream);
+path_list_t *path_list_rotate(path_list_t *self, kinematics_t *kinematics, const point_t *origin, bool keep_last);
+path_list_t *path_list_simplify(path_list_t *self, int32_t tolerance, size_t *removed);
+vector_list_t *path_list_to_vector_list(path_list_t *self);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -1,7 +1,8 @@
 #ifndef __PDF2LASER_TYPE_POINT_H__
 #define __PDF2LASER_TYPE_POINT_H__ 1
 
-#include <stdint.h>  // for int32_t
+#include <stdbool.h>  // for bool
+#include <stdint.h>   // for int32_t, int64_t, uint32_t, uint64_t
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,15 +11,66 @@ extern "C" {
 }
 #endif
 
+// Starting value for point_hash
+#define POINT_HASH_SEED (0x9e3779b97f4a7c15u)
+
 typedef struct point point_t;
 struct point {
 	int32_t x;
 	int32_t y;
 };
 
-point_t *point_create(int32_t x, int32_t y);
-point_t *point_destroy(point_t *self);
-int32_t point_compare(point_t *self, point_t *other);
+/**
+ * Whether two points are the same device position.
+ */
+static inline bool point_equal(const point_t *self, const point_t *other)
+{
+	return self->x == other->x && self->y == other->y;
+}
+
+/**
+ * Order points by x, then y.
+ *
+ * @return negative, zero or positive as self sorts before, with or after other.
+ */
+static inline int32_t point_compare(const point_t *self, const point_t *other)
+{
+	if (self->x != other->x)
+		return (self->x < other->x) ? -1 : 1;
+	if (self->y != other->y)
+		return (self->y < other->y) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Mix a point into a hash, equal points mix in alike.
+ *
+ * @param self the point.
+ * @param hash the hash so far, POINT_HASH_SEED to start one.
+ */
+static inline uint64_t point_hash(const point_t *self, uint64_t hash)
+{
+	uint32_t coordinates[] = { (uint32_t)self->x, (uint32_t)self->y };
+
+	for (int index = 0; index < 2; index += 1) {
+		hash ^= coordinates[index];
+		hash *= 0xff51afd7ed558ccdu;
+		hash ^= hash >> 32;
+	}
+
+	return hash;
+}
+
+/**
+ * Squared distance between two points, exact for points less than 2^31
+ * device units apart along each axis.
+ */
+static inline int64_t point_distance_squared(const point_t *self, const point_t *other)
+{
+	int64_t dx = (int64_t)self->x - other->x;
+	int64_t dy = (int64_t)self->y - other->y;
+	return dx * dx + dy * dy;
+}
 
 #ifdef __cplusplus
 };
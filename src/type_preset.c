@@ -2,15 +2,17 @@
 #include <ctype.h>                    // for tolower
 #include <inttypes.h>                 // for SCNx64
 #include <stdbool.h>                  // for false, true
-#include <stdint.h>                   // for int32_t, int64_t, uint64_t
+#include <stdint.h>                   // for int32_t, int64_t, uint32_t, uint64_t
 #include <stdio.h>                    // for NULL, sscanf
-#include <stdlib.h>                   // for atoi, exit, free, calloc
+#include <stdlib.h>                   // for atoi, exit, free, calloc, strtoll
 #include <string.h>                   // for strndup
 #include <strings.h>                  // for strncasecmp
 #include "config.h"                   // for PRESET_NAME_NCHARS
 #include "ini_file.h"                 // for ini_entry_t, ini_section_t, MAX_FIELD_LENGTH, ini_file_destroy, ini_section_lookup_entry, ini_file_t
+#include "type_kinematics.h"          // for kinematics_t
 #include "type_print_job.h"           // for print_job_t, print_job_append_new_vector_list_config, print_job_find_vector_list_config_by_rgb
 #include "type_raster.h"              // for raster_t, raster_create, raster_mode
+#include "type_vector_list.h"         // for VECTOR_LIST_IMPROVE_MAX, VECTOR_LIST_SWEEPS_MAX
 #include "type_vector_list_config.h"  // for vector_list_config_t, vector_list_config_id_to_rgb
 
 
@@ -133,8 +135,18 @@ static preset_t *preset_load_ini_section_vector(preset_t *self, print_job_t *pri
 			config->frequency = atoi(entry->value);
 			break;
 		}
-		case 's': { // speed (-v SPEED, --vector-speed=COLOR=SPEED)
-			config->speed = atoi(entry->value);
+		case 's': {
+			switch (tolower(entry->key[1])) {
+			case 'p': { // speed (-v SPEED, --vector-speed=COLOR=SPEED)
+				config->speed = atoi(entry->value);
+				break;
+			}
+			case 'i': { // simplify (-S TOLERANCE, --vector-simplify=COLOR=TOLERANCE)
+				int32_t simplify = atoi(entry->value);
+				config->simplify = (simplify < 0) ? -1 : simplify;
+				break;
+			}
+			}
 			break;
 		}
 		case 'p': { // power (-V POWER, --vector-power=COLOR=POWER)
@@ -158,6 +170,34 @@ static preset_t *preset_load_ini_section_vector(preset_t *self, print_job_t *pri
 	return self;
 }
 
+static preset_t *preset_load_ini_section_machine(preset_t *self, print_job_t *print_job, ini_section_t *section)
+{
+	for (ini_entry_t *entry = section->entries; entry != NULL; entry = entry->next) {
+		switch (tolower(entry->key[0])) {
+		case 's': { // transit speed in mm/s
+			print_job->kinematics->speed = atoi(entry->value);
+			break;
+		}
+		case 'a': { // transit acceleration in mm/s^2
+			print_job->kinematics->acceleration = atoi(entry->value);
+			break;
+		}
+		case 'c': { // corner penalty in ms
+			print_job->kinematics->corner = atoi(entry->value);
+			break;
+		}
+		case 'p': { // positional precision in um
+			print_job->kinematics->precision = atoi(entry->value);
+			break;
+		}
+		default: {
+			// error
+		}
+		}
+	}
+	return self;
+}
+
 static preset_t *preset_load_ini_section_preset(preset_t * self, print_job_t *print_job, ini_section_t *section)
 {
 	for (ini_entry_t *entry = section->entries; entry != NULL; entry = entry->next) {
@@ -184,6 +224,28 @@ static preset_t *preset_load_ini_section_preset(preset_t * self, print_job_t *pr
 			}
 			break;
 		}
+		case 'p': { // parts (-G MODE, --vector-parts=MODE)
+			print_job->vector_parts = tolower(entry->value[0]);
+			break;
+		}
+		case 'i': { // improve (-I MS, --vector-improve=MS)
+			long long improve = strtoll(entry->value, NULL, 10);
+			if (improve < 0)
+				improve = 0;
+			else if (improve > VECTOR_LIST_IMPROVE_MAX)
+				improve = VECTOR_LIST_IMPROVE_MAX;
+			print_job->vector_improve = (uint32_t)improve;
+			break;
+		}
+		case 's': { // sweeps (-W N, --vector-sweeps=N)
+			long long sweeps = strtoll(entry->value, NULL, 10);
+			if (sweeps < 0)
+				sweeps = 0;
+			else if (sweeps > VECTOR_LIST_SWEEPS_MAX)
+				sweeps = VECTOR_LIST_SWEEPS_MAX;
+			print_job->vector_sweeps = (uint32_t)sweeps;
+			break;
+		}
 		case 'o': { // optimize (-O, --no-optimize)
 			if (!strncasecmp(entry->value, "true", MAX_FIELD_LENGTH)) {
 				print_job->vector_optimize = true;
@@ -205,6 +267,9 @@ static preset_t *preset_load_ini_section_preset(preset_t * self, print_job_t *pr
 static preset_t *preset_load_ini_section(preset_t * self, print_job_t *print_job, ini_section_t *section)
 {
 	switch (tolower(section->name[0])) {
+	case 'm': { // machine
+		return preset_load_ini_section_machine(self, print_job, section);
+	}
 	case 'p': { // preset
 		return preset_load_ini_section_preset(self, print_job, section);
 	}
@@ -5,14 +5,17 @@
 #include <stdio.h>                    // for snprintf
 #include <stdlib.h>                   // for free, calloc
 #include <string.h>                   // for strlen, strndup
-#include "config.h"                   // for BED_HEIGHT, BED_WIDTH, DEBUG, DEFAULT_HOST, HOSTNAME_NCHARS
+#include "config.h"                   // for BED_HEIGHT, BED_WIDTH, DEBUG, DEFAULT_HOST, HOSTNAME_NCHARS, IN_MEMORY
+#include "type_kinematics.h"          // for kinematics_create, kinematics_destroy
 #include "type_raster.h"              // for raster_t, raster_create, raster_destroy
+#include "type_vector_list.h"         // for VECTOR_LIST_PARTS_NONE
 #include "type_vector_list_config.h"  // for vector_list_config_t, vector_list_config_create, vector_list_config_destroy, vector_list_config_rgb_to_id, vector_list_config_shallow_clone, vector_list_config_to_string
 
 print_job_t *print_job_create(void)
 {
 	print_job_t *print_job = calloc(1, sizeof(print_job_t));
 	print_job->raster = raster_create();
+	print_job->kinematics = kinematics_create();
 
 	print_job->host = strndup(DEFAULT_HOST, HOSTNAME_NCHARS);
 	print_job->mode = PRINT_JOB_MODE_COMBINED;
@@ -20,8 +23,18 @@ print_job_t *print_job_create(void)
 	print_job->width = BED_WIDTH;
 	print_job->focus = false;
 	print_job->vector_optimize = true;
+	print_job->vector_parts = VECTOR_LIST_PARTS_NONE;
+	print_job->vector_improve = 0;
+	print_job->vector_sweeps = 0;
 	print_job->vector_fallthrough = true;
+	print_job->vector_binary = false;
 	print_job->configs = NULL;
+#ifdef HAVE_MEMFD_CREATE
+	print_job->in_memory = IN_MEMORY;
+#else
+	print_job->in_memory = false;
+#endif
+	print_job->threads = 0;
 	print_job->debug = DEBUG;
 
 	return print_job;
@@ -37,6 +50,7 @@ print_job_t *print_job_destroy(print_job_t *self)
 	free(self->name);
 
 	raster_destroy(self->raster);
+	kinematics_destroy(self->kinematics);
 
 	size_t config_count = 0;
 	for (vector_list_config_t *config = self->configs; config != NULL; config = config->next) {
@@ -137,6 +151,7 @@ vector_list_config_t *print_job_clone_last_vector_list_config(print_job_t *self,
 		config = config->next;
 	}
 	vector_list_config_t *config_shallow_clone = vector_list_config_shallow_clone(config, red, green, blue);
+	config_shallow_clone->fallthrough = true;
 	return print_job_append_vector_list_config(self, config_shallow_clone);
 }
 
@@ -156,3 +171,19 @@ vector_list_config_t *print_job_find_vector_list_config_by_rgb(print_job_t *self
 {
 	return print_job_find_vector_list_config_by_id(self, vector_list_config_rgb_to_id(red, green, blue));
 }
+
+/**
+ * Whether the job engraves, and so needs the page rendered to a bitmap.
+ */
+bool print_job_has_raster(print_job_t *self)
+{
+	return self->mode == PRINT_JOB_MODE_RASTER || self->mode == PRINT_JOB_MODE_COMBINED;
+}
+
+/**
+ * Whether the job cuts, and so needs the vectors of the page.
+ */
+bool print_job_has_vector(print_job_t *self)
+{
+	return self->mode == PRINT_JOB_MODE_VECTOR || self->mode == PRINT_JOB_MODE_COMBINED;
+}
@@ -3,7 +3,9 @@
 
 #include <stdbool.h>                  // for bool
 #include <stdint.h>                   // for int32_t, uint32_t
+#include "type_kinematics.h"          // for kinematics_t
 #include "type_raster.h"              // for raster_t
+#include "type_vector_list.h"         // for vector_list_parts
 #include "type_vector_list_config.h"  // for vector_list_config_t
 
 #ifdef __cplusplus
@@ -35,10 +37,18 @@ struct print_job {
 	raster_t *raster;
 
 	bool vector_optimize;
+	vector_list_parts vector_parts;
+	uint32_t vector_improve;
+	uint32_t vector_sweeps;
+
+	kinematics_t *kinematics;
 	bool vector_fallthrough;
+	bool vector_binary;
 
 	vector_list_config_t *configs;
 
+	bool in_memory;
+	uint32_t threads;
 	bool debug;
 };
 
@@ -55,6 +65,9 @@ vector_list_config_t *print_job_append_new_vector_list_config(print_job_t *self,
 
 vector_list_config_t *print_job_find_vector_list_config_by_rgb(print_job_t *self, int32_t red, int32_t green, int32_t blue);
 
+bool print_job_has_raster(print_job_t *self);
+bool print_job_has_vector(print_job_t *self);
+
 #ifdef __cplusplus
 };
 #endif
@@ -17,21 +17,6 @@ char *raster_mode_to_string(raster_mode mode)
 	}
 }
 
-char *raster_mode_to_device_string(raster_mode mode)
-{
-	switch (mode) {
-	case RASTER_MODE_COLOR:
-		return "bmp16m";
-	case RASTER_MODE_GREY_SCALE:
-		return "bmpgray";
-	case RASTER_MODE_MONO:
-		return "bmpmono";
-	case RASTER_MODE_NONE:
-	default:
-		return NULL;
-	}
-}
-
 raster_t *raster_create(void)
 {
 	raster_t *raster = calloc(1, sizeof(raster_t));
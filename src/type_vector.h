@@ -1,8 +1,9 @@
 #ifndef __PDF2LASER_TYPE_VECTOR_H__
 #define __PDF2LASER_TYPE_VECTOR_H__ 1
 
-#include <stdint.h>      // for int32_t
-#include "type_point.h"  // for point_t
+#include <stdbool.h>     // for bool
+#include <stdint.h>      // for int32_t, uint64_t
+#include "type_point.h"  // for point_t, point_compare, point_equal, point_hash, POINT_HASH_SEED
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,21 +12,51 @@ extern "C" {
 }
 #endif
 
+/**
+ * A single cut from start to end. Vectors are plain values, lists of them
+ * are stored by vector_list_t.
+ */
 typedef struct vector vector_t;
 struct vector {
-	point_t *start;
-	point_t *end;
-
-	vector_t *next;
-	vector_t *prev;
+	point_t start;
+	point_t end;
 };
 
-vector_t *vector_create(int32_t start_x, int32_t start_y, int32_t end_x, int32_t end_y);
-vector_t *vector_destroy(vector_t *self);
-int32_t vector_compare(vector_t *self, vector_t *other);
-
 vector_t *vector_flip(vector_t *self);
 
+/**
+ * Whether two vectors run between the same points in the same direction.
+ */
+static inline bool vector_equal(const vector_t *self, const vector_t *other)
+{
+	return point_equal(&self->start, &other->start) && point_equal(&self->end, &other->end);
+}
+
+/**
+ * Order the endpoints of a vector so that it and its reverse are equal.
+ *
+ * @return Whether the vector was flipped.
+ */
+static inline bool vector_normalize(vector_t *self)
+{
+	if (point_compare(&self->start, &self->end) <= 0)
+		return false;
+
+	point_t start = self->start;
+	self->start = self->end;
+	self->end = start;
+	return true;
+}
+
+/**
+ * Hash of a vector, equal vectors hash alike. Normalize first for a hash
+ * which ignores direction.
+ */
+static inline uint64_t vector_hash(const vector_t *self)
+{
+	return point_hash(&self->end, point_hash(&self->start, POINT_HASH_SEED));
+}
+
 #ifdef __cplusplus
 };
 #endif
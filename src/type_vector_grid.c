@@ -0,0 +1,399 @@
+#include "type_vector_grid.h"
+#include <math.h>              // for sqrt
+#include <stdbool.h>           // for bool, false, true
+#include <stddef.h>            // for size_t, NULL
+#include <stdint.h>            // for int64_t, INT64_MAX, INT64_MIN
+#include <stdlib.h>            // for calloc, free
+#include "type_point.h"        // for point_t
+#include "type_vector_list.h"  // for vector_list_t
+
+/*
+ * Entries are endpoint ids, the vector index times two, plus one for the end
+ * point.
+ */
+static int64_t vector_grid_endpoint_x(vector_grid_t *self, size_t entry)
+{
+	return (entry & 1) ? self->list->end_x[entry >> 1] : self->list->start_x[entry >> 1];
+}
+
+static int64_t vector_grid_endpoint_y(vector_grid_t *self, size_t entry)
+{
+	return (entry & 1) ? self->list->end_y[entry >> 1] : self->list->start_y[entry >> 1];
+}
+
+static int64_t vector_grid_column(vector_grid_t *self, int64_t x)
+{
+	int64_t column = (x - self->x_origin) / self->cell_size;
+	return (column < 0) ? 0 : (column >= self->columns) ? self->columns - 1 : column;
+}
+
+static int64_t vector_grid_row(vector_grid_t *self, int64_t y)
+{
+	int64_t row = (y - self->y_origin) / self->cell_size;
+	return (row < 0) ? 0 : (row >= self->rows) ? self->rows - 1 : row;
+}
+
+/**
+ * (Re)build the cells over the vectors which have not been taken yet.
+ */
+static bool vector_grid_build(vector_grid_t *self)
+{
+	vector_list_t *list = self->list;
+
+	int64_t x_min = INT64_MAX, y_min = INT64_MAX;
+	int64_t x_max = INT64_MIN, y_max = INT64_MIN;
+	for (size_t index = 0; index < list->length; index += 1) {
+		if (self->removed[index])
+			continue;
+		for (size_t entry = 2 * index; entry < 2 * index + 2; entry += 1) {
+			int64_t x = vector_grid_endpoint_x(self, entry);
+			int64_t y = vector_grid_endpoint_y(self, entry);
+			x_min = (x < x_min) ? x : x_min;
+			y_min = (y < y_min) ? y : y_min;
+			x_max = (x > x_max) ? x : x_max;
+			y_max = (y > y_max) ? y : y_max;
+		}
+	}
+
+	size_t endpoints = 2 * self->live;
+	if (endpoints == 0) {
+		x_min = y_min = x_max = y_max = 0;
+	}
+
+	int64_t width = x_max - x_min + 1;
+	int64_t height = y_max - y_min + 1;
+
+	size_t cells_wanted = endpoints / VECTOR_GRID_CELL_ENDPOINTS + 1;
+	int64_t cell_size = (int64_t)sqrt((double)width * (double)height / (double)cells_wanted);
+	if (cell_size < 1)
+		cell_size = 1;
+	// Long thin jobs would otherwise get far more cells than endpoints
+	while ((width / cell_size + 1) * (height / cell_size + 1) > (int64_t)(4 * cells_wanted + 16))
+		cell_size *= 2;
+
+	free(self->cell_start);
+	free(self->cell_live);
+	free(self->entries);
+
+	self->x_origin = x_min;
+	self->y_origin = y_min;
+	self->cell_size = cell_size;
+	self->columns = width / cell_size + 1;
+	self->rows = height / cell_size + 1;
+
+	size_t cells = (size_t)(self->columns * self->rows);
+	self->cell_start = calloc(cells + 1, sizeof(size_t));
+	self->cell_live = calloc(cells, sizeof(size_t));
+	self->entries = calloc(endpoints + 1, sizeof(size_t));
+	if (self->cell_start == NULL || self->cell_live == NULL || self->entries == NULL)
+		return false;
+
+	// Counting sort of the endpoints into their cells, in index order
+	for (size_t index = 0; index < list->length; index += 1) {
+		if (self->removed[index])
+			continue;
+		for (size_t entry = 2 * index; entry < 2 * index + 2; entry += 1) {
+			int64_t cell = vector_grid_row(self, vector_grid_endpoint_y(self, entry)) * self->columns +
+				vector_grid_column(self, vector_grid_endpoint_x(self, entry));
+			self->cell_live[cell] += 1;
+		}
+	}
+
+	for (size_t cell = 0; cell < cells; cell += 1)
+		self->cell_start[cell + 1] = self->cell_start[cell] + self->cell_live[cell];
+
+	size_t *cell_fill = calloc(cells, sizeof(size_t));
+	if (cell_fill == NULL)
+		return false;
+
+	for (size_t index = 0; index < list->length; index += 1) {
+		if (self->removed[index])
+			continue;
+		for (size_t entry = 2 * index; entry < 2 * index + 2; entry += 1) {
+			int64_t cell = vector_grid_row(self, vector_grid_endpoint_y(self, entry)) * self->columns +
+				vector_grid_column(self, vector_grid_endpoint_x(self, entry));
+			self->entries[self->cell_start[cell] + cell_fill[cell]] = entry;
+			cell_fill[cell] += 1;
+		}
+	}
+
+	free(cell_fill);
+
+	self->indexed = self->live;
+
+	return true;
+}
+
+vector_grid_t *vector_grid_create(vector_list_t *list)
+{
+	vector_grid_t *vector_grid = calloc(1, sizeof(vector_grid_t));
+	if (vector_grid == NULL)
+		return NULL;
+
+	vector_grid->list = list;
+	vector_grid->live = list->length;
+	vector_grid->removed = calloc(list->length + 1, sizeof(bool));
+	if (vector_grid->removed == NULL || !vector_grid_build(vector_grid))
+		return vector_grid_destroy(vector_grid);
+
+	return vector_grid;
+}
+
+vector_grid_t *vector_grid_destroy(vector_grid_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	free(self->removed);
+	free(self->cell_start);
+	free(self->cell_live);
+	free(self->entries);
+	free(self);
+
+	return NULL;
+}
+
+/**
+ * Take a vector out of the grid without searching for it.
+ *
+ * @param self the grid.
+ * @param index the index of the vector in the list.
+ */
+void vector_grid_remove(vector_grid_t *self, size_t index)
+{
+	if (self->removed[index])
+		return;
+
+	self->removed[index] = true;
+	self->live -= 1;
+
+	// Keep the per cell counts so emptied cells are skipped
+	for (size_t entry = 2 * index; entry < 2 * index + 2; entry += 1) {
+		int64_t cell = vector_grid_row(self, vector_grid_endpoint_y(self, entry)) * self->columns +
+			vector_grid_column(self, vector_grid_endpoint_x(self, entry));
+		self->cell_live[cell] -= 1;
+	}
+}
+
+/**
+ * Consider every live endpoint of a cell against the best found so far.
+ * Nearer wins, then the lower vector index, then the start point, which is
+ * the order a linear scan of the list would find them in.
+ */
+static void vector_grid_scan_cell(vector_grid_t *self, int64_t cell, int64_t px, int64_t py,
+                                  int64_t *best_distance, size_t *best_entry)
+{
+	if (self->cell_live[cell] == 0)
+		return;
+
+	for (size_t position = self->cell_start[cell]; position < self->cell_start[cell + 1]; position += 1) {
+		size_t entry = self->entries[position];
+		if (self->removed[entry >> 1])
+			continue;
+
+		int64_t dx = px - vector_grid_endpoint_x(self, entry);
+		int64_t dy = py - vector_grid_endpoint_y(self, entry);
+		int64_t distance = dx * dx + dy * dy;
+
+		if (distance < *best_distance || (distance == *best_distance && entry < *best_entry)) {
+			*best_distance = distance;
+			*best_entry = entry;
+		}
+	}
+}
+
+/**
+ * Lower bound on the distance from a point to any cell outside the square of
+ * cells scanned so far, the nearest side which still has cells beyond it.
+ *
+ * @return INT64_MAX once the square covers the whole grid.
+ */
+static int64_t vector_grid_ring_bound(vector_grid_t *self, int64_t px, int64_t py,
+                                      int64_t column_lo, int64_t column_hi, int64_t row_lo, int64_t row_hi)
+{
+	int64_t bound = INT64_MAX;
+	if (column_lo > 0) {
+		int64_t side = px - (self->x_origin + column_lo * self->cell_size);
+		bound = (side < bound) ? side : bound;
+	}
+	if (column_hi < self->columns - 1) {
+		int64_t side = (self->x_origin + (column_hi + 1) * self->cell_size) - px;
+		bound = (side < bound) ? side : bound;
+	}
+	if (row_lo > 0) {
+		int64_t side = py - (self->y_origin + row_lo * self->cell_size);
+		bound = (side < bound) ? side : bound;
+	}
+	if (row_hi < self->rows - 1) {
+		int64_t side = (self->y_origin + (row_hi + 1) * self->cell_size) - py;
+		bound = (side < bound) ? side : bound;
+	}
+	return bound;
+}
+
+/**
+ * Find the vector with an endpoint nearest to point and take it out of the
+ * grid.
+ *
+ * @param self the grid.
+ * @param point the point to search from.
+ * @param index set to the index of the vector in the list.
+ * @param reverse set when the end point is the nearer, and the vector should
+ * be cut in reverse.
+ *
+ * @return false once every vector has been taken.
+ */
+bool vector_grid_take_closest(vector_grid_t *self, const point_t *point, size_t *index, bool *reverse)
+{
+	if (self->live == 0)
+		return false;
+
+	// Searching a mostly empty grid walks mostly empty cells
+	if (self->live * 4 < self->indexed && !vector_grid_build(self))
+		return false;
+
+	int64_t px = point->x;
+	int64_t py = point->y;
+
+	int64_t column = vector_grid_column(self, px);
+	int64_t row = vector_grid_row(self, py);
+
+	int64_t best_distance = INT64_MAX;
+	size_t best_entry = SIZE_MAX;
+
+	for (int64_t radius = 0; ; radius += 1) {
+		int64_t column_lo = column - radius, column_hi = column + radius;
+		int64_t row_lo = row - radius, row_hi = row + radius;
+
+		// Walk the ring of cells at this radius, clipped to the grid
+		for (int64_t r = (row_lo < 0 ? 0 : row_lo); r <= row_hi && r < self->rows; r += 1) {
+			bool edge_row = (r == row_lo || r == row_hi);
+			for (int64_t c = (column_lo < 0 ? 0 : column_lo); c <= column_hi && c < self->columns; c += 1) {
+				if (!edge_row && c != column_lo && c != column_hi) {
+					// Skip the inside of the ring
+					c = column_hi - 1;
+					continue;
+				}
+				vector_grid_scan_cell(self, r * self->columns + c, px, py, &best_distance, &best_entry);
+			}
+		}
+
+		int64_t bound = vector_grid_ring_bound(self, px, py, column_lo, column_hi, row_lo, row_hi);
+		if (bound == INT64_MAX)
+			break;
+		if (bound > 0 && best_entry != SIZE_MAX && bound * bound > best_distance)
+			break;
+	}
+
+	*index = best_entry >> 1;
+	*reverse = (best_entry & 1) != 0;
+
+	vector_grid_remove(self, *index);
+
+	return true;
+}
+
+/**
+ * Offer an endpoint of a vector to the sorted list of the nearest found so
+ * far, each vector appears once at the distance of its nearer endpoint.
+ */
+static void vector_grid_offer(size_t index, int64_t distance, size_t count, size_t *found,
+                              int64_t *distances, size_t *indices)
+{
+	size_t position = *found;
+	for (size_t slot = 0; slot < *found; slot += 1) {
+		if (indices[slot] == index) {
+			if (distances[slot] <= distance)
+				return;
+			position = slot;
+			break;
+		}
+	}
+
+	if (position == *found) {
+		if (*found < count)
+			*found += 1;
+		else if (distance > distances[count - 1] || (distance == distances[count - 1] && index > indices[count - 1]))
+			return;
+		else
+			position = count - 1;
+	}
+
+	// Sift the new distance down into place
+	while (position > 0 && (distances[position - 1] > distance ||
+	                        (distances[position - 1] == distance && indices[position - 1] > index))) {
+		distances[position] = distances[position - 1];
+		indices[position] = indices[position - 1];
+		position -= 1;
+	}
+	distances[position] = distance;
+	indices[position] = index;
+}
+
+/**
+ * Find the vectors with an endpoint nearest to point, leaving them in the
+ * grid.
+ *
+ * @param self the grid.
+ * @param point the point to search from.
+ * @param count the most vectors to find.
+ * @param indices filled with the indices of the vectors found, nearest first.
+ *
+ * @return The number of vectors found, fewer than count only when the grid
+ * holds fewer, 0 as well if the grid could not be rebuilt.
+ */
+size_t vector_grid_nearest(vector_grid_t *self, const point_t *point, size_t count, size_t *indices)
+{
+	if (self->live == 0 || count == 0)
+		return 0;
+
+	// Searching a mostly empty grid walks mostly empty cells
+	if (self->live * 4 < self->indexed && !vector_grid_build(self))
+		return 0;
+
+	int64_t px = point->x;
+	int64_t py = point->y;
+
+	int64_t column = vector_grid_column(self, px);
+	int64_t row = vector_grid_row(self, py);
+
+	int64_t distances[count];
+	size_t found = 0;
+
+	for (int64_t radius = 0; ; radius += 1) {
+		int64_t column_lo = column - radius, column_hi = column + radius;
+		int64_t row_lo = row - radius, row_hi = row + radius;
+
+		for (int64_t r = (row_lo < 0 ? 0 : row_lo); r <= row_hi && r < self->rows; r += 1) {
+			bool edge_row = (r == row_lo || r == row_hi);
+			for (int64_t c = (column_lo < 0 ? 0 : column_lo); c <= column_hi && c < self->columns; c += 1) {
+				if (!edge_row && c != column_lo && c != column_hi) {
+					c = column_hi - 1;
+					continue;
+				}
+
+				int64_t cell = r * self->columns + c;
+				if (self->cell_live[cell] == 0)
+					continue;
+
+				for (size_t position = self->cell_start[cell]; position < self->cell_start[cell + 1]; position += 1) {
+					size_t entry = self->entries[position];
+					if (self->removed[entry >> 1])
+						continue;
+
+					int64_t dx = px - vector_grid_endpoint_x(self, entry);
+					int64_t dy = py - vector_grid_endpoint_y(self, entry);
+					vector_grid_offer(entry >> 1, dx * dx + dy * dy, count, &found, distances, indices);
+				}
+			}
+		}
+
+		int64_t bound = vector_grid_ring_bound(self, px, py, column_lo, column_hi, row_lo, row_hi);
+		if (bound == INT64_MAX)
+			break;
+		if (bound > 0 && found == count && bound * bound > distances[count - 1])
+			break;
+	}
+
+	return found;
+}
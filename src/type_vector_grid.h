@@ -0,0 +1,56 @@
+#ifndef __PDF2LASER_TYPE_VECTOR_GRID_H__
+#define __PDF2LASER_TYPE_VECTOR_GRID_H__ 1
+
+#include <stdbool.h>           // for bool
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t, int64_t
+#include "type_point.h"        // for point_t
+#include "type_vector_list.h"  // for vector_list_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+// Endpoints per cell the grid is sized for
+#define VECTOR_GRID_CELL_ENDPOINTS 2
+
+/**
+ * Uniform grid over the endpoints of a vector list, answering which vectors
+ * have an endpoint nearest a point. Vectors can be taken out as they are
+ * found, the list itself is left untouched, and the grid is rebuilt over what
+ * is left once most of it is empty.
+ */
+typedef struct vector_grid vector_grid_t;
+struct vector_grid {
+	vector_list_t *list;
+
+	bool *removed;
+	size_t live;
+	size_t indexed;
+
+	int64_t x_origin;
+	int64_t y_origin;
+	int64_t cell_size;
+	int64_t columns;
+	int64_t rows;
+
+	size_t *cell_start;
+	size_t *cell_live;
+	size_t *entries;
+};
+
+vector_grid_t *vector_grid_create(vector_list_t *list);
+vector_grid_t *vector_grid_destroy(vector_grid_t *self);
+
+void vector_grid_remove(vector_grid_t *self, size_t index);
+bool vector_grid_take_closest(vector_grid_t *self, const point_t *point, size_t *index, bool *reverse);
+size_t vector_grid_nearest(vector_grid_t *self, const point_t *point, size_t count, size_t *indices);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
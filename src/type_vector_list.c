@@ -1,16 +1,26 @@
 #include "type_vector_list.h"
-#include <inttypes.h>     // for PRId32, PRId64
-#include <math.h>         // for pow, powl, sqrt
-#include <stdio.h>        // for NULL, printf, size_t
-#include <stdlib.h>       // for calloc, free
-#include "type_vector.h"  // for vector_t, vector_compare, vector_destroy, vector_flip
+#include <inttypes.h>           // for PRId32, PRId64
+#include <math.h>               // for sqrt
+#include <stdbool.h>            // for bool, false, true
+#include <stdint.h>             // for int32_t, int64_t
+#include <stdio.h>              // for FILE, NULL, fprintf, size_t
+#include <stdlib.h>             // for calloc, free, llabs, qsort, realloc
+#include "type_path_list.h"     // for path_list_t, path_list_destroy, path_list_from_vector_list, path_list_simplify, path_list_to_vector_list
+#include "type_point.h"         // for point_t, point_compare
+#include "type_vector.h"        // for vector_t
 
 vector_list_t *vector_list_create(void)
 {
 	vector_list_t *list = calloc(1, sizeof(vector_list_t));
-	list->head = NULL;
-	list->tail = NULL;
+	if (list == NULL)
+		return NULL;
+
+	list->start_x = NULL;
+	list->start_y = NULL;
+	list->end_x = NULL;
+	list->end_y = NULL;
 	list->length = 0;
+	list->capacity = 0;
 	return list;
 }
 
@@ -19,163 +29,259 @@ vector_list_t *vector_list_destroy(vector_list_t *self)
 	if (self == NULL)
 		return NULL;
 
-	vector_t *vectors[self->length];
-	size_t index = 0;
-	for (vector_t *vector = self->head; vector != NULL; vector = vector->next) {
-		vectors[index] = vector;
-		index += 1;
-	}
-
-	for (index = 0; index < (size_t)self->length; index += 1) {
-		vector_destroy(vectors[index]);
-	}
+	free(self->start_x);
+	free(self->start_y);
+	free(self->end_x);
+	free(self->end_y);
 
 	free(self);
 
 	return NULL;
 }
 
-vector_list_t *vector_list_append(vector_list_t *self, vector_t *vector)
+static bool vector_list_reserve(vector_list_t *self, size_t capacity)
 {
-	if (self->head == NULL) {
-		self->head = vector;
-		self->tail = vector;
-		self->length = 1;
-	}
-	else {
-		vector->prev = self->tail;
-		self->tail->next = vector;
-		self->tail = vector;
-		self->length += 1;
+	if (capacity <= self->capacity)
+		return true;
+
+	size_t new_capacity = (self->capacity > 0) ? self->capacity : VECTOR_LIST_INITIAL_CAPACITY;
+	while (new_capacity < capacity)
+		new_capacity *= 2;
+
+	int32_t **columns[] = { &self->start_x, &self->start_y, &self->end_x, &self->end_y };
+	for (size_t index = 0; index < sizeof(columns) / sizeof(*columns); index += 1) {
+		int32_t *column = realloc(*columns[index], new_capacity * sizeof(int32_t));
+		if (column == NULL)
+			return false;
+		*columns[index] = column;
 	}
-	return self;
+
+	self->capacity = new_capacity;
+	return true;
 }
 
-vector_t *vector_list_remove(vector_list_t *self, vector_t *vector)
+/**
+ * Add a copy of a vector to the end of the list.
+ *
+ * @return The list, NULL if it could not grow.
+ */
+vector_list_t *vector_list_append(vector_list_t *self, const vector_t *vector)
 {
-	vector_t *next = vector->next;
-	vector_t *prev = vector->prev;
-
-	// un-link node
-	if (next) {
-		next->prev = prev;
-	}
-
-	if (prev) {
-		prev->next = next;
-	}
-
-	vector->next = NULL;
-	vector->prev = NULL;
-
-	// correct list pointers
-	if (self->head == vector) {
-		self->head = next;
-	}
+	if (!vector_list_reserve(self, self->length + 1))
+		return NULL;
 
-	if (self->tail == vector) {
-		self->tail = prev;
-	}
+	size_t index = self->length;
+	self->start_x[index] = vector->start.x;
+	self->start_y[index] = vector->start.y;
+	self->end_x[index] = vector->end.x;
+	self->end_y[index] = vector->end.y;
+	self->length += 1;
 
-	// reduce length
-	self->length -= 0;
+	return self;
+}
 
-	// return pointer to be freed
+/**
+ * Copy out the vector at index.
+ */
+vector_t *vector_list_get(vector_list_t *self, size_t index, vector_t *vector)
+{
+	vector->start.x = self->start_x[index];
+	vector->start.y = self->start_y[index];
+	vector->end.x = self->end_x[index];
+	vector->end.y = self->end_y[index];
 	return vector;
 }
 
-int vector_list_contains(vector_list_t *self, vector_t *vector)
+/*
+ * A vector placed on its line. The reduced direction and the offset name the
+ * line exactly, the projections of the ends order them along it.
+ */
+struct vector_list_span {
+	int64_t dx;      // Direction reduced by its gcd, dx > 0, or dx == 0 and dy > 0
+	int64_t dy;
+	int64_t offset;  // dy * x - dx * y, the same for every point on the line
+	int64_t first;   // dx * x + dy * y of the nearer end
+	int64_t last;    // and of the further end
+	size_t index;
+	bool reversed;   // Whether the vector runs from the further end to the nearer
+};
+
+static int64_t vector_list_gcd(int64_t a, int64_t b)
 {
-	size_t index = 0;
-	vector_t *v = self->head;
-	while (v) {
-		if (vector_compare(vector, v) == 0) {
-			return index;
-		}
-		index += 1;
-		v = v->next;
+	while (b != 0) {
+		int64_t r = a % b;
+		a = b;
+		b = r;
 	}
-	return -1;
+	return a;
+}
+
+static int vector_list_span_compare(const void *a, const void *b)
+{
+	const struct vector_list_span *self = a;
+	const struct vector_list_span *other = b;
+
+	if (self->dx != other->dx)
+		return (self->dx < other->dx) ? -1 : 1;
+	if (self->dy != other->dy)
+		return (self->dy < other->dy) ? -1 : 1;
+	if (self->offset != other->offset)
+		return (self->offset < other->offset) ? -1 : 1;
+	if (self->first != other->first)
+		return (self->first < other->first) ? -1 : 1;
+	// Longest first, so shorter spans starting at the same place fall inside it
+	if (self->last != other->last)
+		return (self->last > other->last) ? -1 : 1;
+	return (self->index < other->index) ? -1 : (self->index > other->index);
 }
 
-/** Find the closest vector to a given point and remove it from the list.
+/**
+ * Trim vectors which overlap along a common line to their union, so shared
+ * edges are cut once. Vectors are grouped by the exact line through their
+ * integer ends and swept along it: one lying inside what is already covered
+ * is dropped, one reaching past it is cut back to start where the covered
+ * run ends. Vectors that only touch end to end are left whole.
  *
- * This might reverse a vector if it is closest to draw it in reverse
- * order.
+ * This does not alter self, a new list is returned with the surviving
+ * vectors in their original order and direction.
  */
-//static vector_t *vector_find_closest(vector_t *vector, const int32_t cx, const int32_t cy)
-vector_t *vector_list_find_closest(vector_list_t *list, point_t *point)
+vector_list_t *vector_list_trim_overlaps(vector_list_t *self, FILE *stream)
 {
-	vector_t *best_vector = NULL;
-	int64_t best_distance = INT64_MAX;
-
-	int64_t distance;
-	int32_t distance_x, distance_y;
-
-	bool reverse = false;
-
-	vector_t *vector = list->head;
-	while (vector) {
-		// check starting point
-		distance_x = point->x - vector->start->x;
-		distance_y = point->y - vector->start->y;
-		distance = powl(distance_x, 2) + powl(distance_y, 2);
-		if (distance < best_distance) {
-			best_vector = vector;
-			best_distance = distance;
-			reverse = false;
-		}
+	vector_list_t *list = vector_list_create();
+	if (list == NULL)
+		return NULL;
+
+	if (!vector_list_reserve(list, self->length))
+		return vector_list_destroy(list);
+
+	struct vector_list_span *spans = calloc(self->length + 1, sizeof(struct vector_list_span));
+	vector_t *vectors = calloc(self->length + 1, sizeof(vector_t));
+	bool *dropped = calloc(self->length + 1, sizeof(bool));
+	if (spans == NULL || vectors == NULL || dropped == NULL) {
+		free(spans);
+		free(vectors);
+		free(dropped);
+		return vector_list_destroy(list);
+	}
+
+	size_t span_count = 0;
+	for (size_t index = 0; index < self->length; index += 1) {
+		vector_t *vector = vector_list_get(self, index, &vectors[index]);
+
+		int64_t dx = (int64_t)vector->end.x - vector->start.x;
+		int64_t dy = (int64_t)vector->end.y - vector->start.y;
+		if (dx == 0 && dy == 0)
+			continue;
+
+		int64_t divisor = vector_list_gcd(llabs(dx), llabs(dy));
+		bool reversed = point_compare(&vector->start, &vector->end) > 0;
+		dx = (reversed ? -dx : dx) / divisor;
+		dy = (reversed ? -dy : dy) / divisor;
+
+		const point_t *near = reversed ? &vector->end : &vector->start;
+		const point_t *far = reversed ? &vector->start : &vector->end;
+
+		struct vector_list_span *span = &spans[span_count++];
+		span->dx = dx;
+		span->dy = dy;
+		span->offset = dy * near->x - dx * near->y;
+		span->first = dx * near->x + dy * near->y;
+		span->last = dx * far->x + dy * far->y;
+		span->index = index;
+		span->reversed = reversed;
+	}
 
-		// check ending point
-		distance_x = point->x - vector->end->x;
-		distance_y = point->y - vector->end->y;
-		distance = powl(distance_x, 2) + powl(distance_y, 2);
-		if (distance < best_distance) {
-			best_vector = vector;
-			best_distance = distance;
-			reverse = true;
+	qsort(spans, span_count, sizeof(struct vector_list_span), vector_list_span_compare);
+
+	size_t trimmed = 0;
+	size_t removed = 0;
+	int64_t saved = 0;
+	for (size_t group = 0; group < span_count; ) {
+		size_t end = group + 1;
+		while (end < span_count && spans[end].dx == spans[group].dx && spans[end].dy == spans[group].dy &&
+		       spans[end].offset == spans[group].offset)
+			end += 1;
+
+		// How far along the line is already cut, and the point it is cut to
+		int64_t reach = spans[group].last;
+		vector_t *reacher = &vectors[spans[group].index];
+		point_t reach_point = spans[group].reversed ? reacher->start : reacher->end;
+
+		for (size_t index = group + 1; index < end; index += 1) {
+			struct vector_list_span *span = &spans[index];
+			vector_t *vector = &vectors[span->index];
+			double scale = sqrt((double)(span->dx * span->dx + span->dy * span->dy));
+
+			if (span->last <= reach) {
+				dropped[span->index] = true;
+				removed += 1;
+				saved += (int64_t)((span->last - span->first) / scale);
+				continue;
+			}
+
+			if (span->first < reach) {
+				point_t *near = span->reversed ? &vector->end : &vector->start;
+				*near = reach_point;
+				trimmed += 1;
+				saved += (int64_t)((reach - span->first) / scale);
+			}
+
+			reach = span->last;
+			reach_point = span->reversed ? vector->start : vector->end;
 		}
 
-		vector = vector->next;
+		group = end;
 	}
 
-	if (best_vector == NULL)
-		return NULL;
+	for (size_t index = 0; index < self->length; index += 1) {
+		if (!dropped[index])
+			vector_list_append(list, &vectors[index]);
+	}
 
-	// remove vector from the list
-	vector_list_remove(list, best_vector);
+	free(spans);
+	free(vectors);
+	free(dropped);
 
-	if (reverse)
-		vector_flip(best_vector);
+	fprintf(stream, "Overlap: %zu vectors trimmed, %zu removed, len %"PRId64" saved\n", trimmed, removed, saved);
 
-	return best_vector;
+	return list;
 }
 
 /**
- * Optimize the cut order to minimize transit time.
- *
- * Simplistic greedy algorithm: look for the closest vector that starts
- * or ends at the same point as the current point.
+ * Trim the points of the paths the vectors trace: repeats and points on a
+ * straight run always, and with a positive tolerance every point that lies
+ * within tolerance device units of the simplified path. Only vectors that
+ * follow on from one another are merged, the order is kept.
  *
- * This does not split vectors.
+ * This does not alter self, a new list is returned.
  */
-vector_list_t *vector_list_optimize(vector_list_t *self)
+vector_list_t *vector_list_simplify(vector_list_t *self, int32_t tolerance, FILE *stream)
 {
-	vector_list_t *list = vector_list_create();
-	point_t *current_point = &(point_t){ 0, 0 };
+	path_list_t *paths = path_list_from_vector_list(self);
+	if (paths == NULL)
+		return NULL;
 
-	while (self->head) {
-		vector_t *vector = vector_list_find_closest(self, current_point);
-		vector_list_append(list, vector);
-		current_point = vector->end;
+	size_t points = paths->point_count;
+	size_t removed = 0;
+	if (path_list_simplify(paths, tolerance, &removed) == NULL) {
+		path_list_destroy(paths);
+		return NULL;
 	}
 
-	vector_list_stats(list);
+	vector_list_t *list = path_list_to_vector_list(paths);
+	path_list_destroy(paths);
+	if (list == NULL)
+		return NULL;
+
+	fprintf(stream, "Simplify: %zu of %zu points removed\n", removed, points);
 
 	return list;
 }
 
-vector_list_t *vector_list_stats(vector_list_t *self)
+/**
+ * Report the cuts and the moves between them, starting from the origin.
+ */
+vector_list_t *vector_list_stats(vector_list_t *self, const point_t *origin, FILE *stream)
 {
 	int32_t transits = 0;
 	int64_t transit_total = 0;
@@ -183,34 +289,32 @@ vector_list_t *vector_list_stats(vector_list_t *self)
 	int32_t cuts = 0;
 	int64_t cut_total = 0;
 
-	int32_t current_x = 0;
-	int32_t current_y = 0;
+	int32_t current_x = origin->x;
+	int32_t current_y = origin->y;
 
-	vector_t *vector = self->head;
-	while (vector) {
-		int32_t transit_dx = current_x - vector->start->x;
-		int32_t transit_dy = current_y - vector->start->y;
-		int64_t transit_length = sqrt(pow(transit_dx, 2) + pow(transit_dy, 2));
+	for (size_t index = 0; index < self->length; index += 1) {
+		int64_t transit_dx = current_x - self->start_x[index];
+		int64_t transit_dy = current_y - self->start_y[index];
+		int64_t transit_length = sqrt(transit_dx * transit_dx + transit_dy * transit_dy);
 		if (transit_length) {
 			transits += 1;
 			transit_total += transit_length;
 		}
 
-		int64_t cut_dx = vector->start->x - vector->end->x;
-		int64_t cut_dy = vector->start->y - vector->end->y;
-		int64_t cut_length = sqrt(pow(cut_dx, 2) + pow(cut_dy, 2));
+		int64_t cut_dx = self->start_x[index] - self->end_x[index];
+		int64_t cut_dy = self->start_y[index] - self->end_y[index];
+		int64_t cut_length = sqrt(cut_dx * cut_dx + cut_dy * cut_dy);
 		if (cut_length) {
 			cuts += 1;
 			cut_total += cut_length;
 		}
 
-		current_x = vector->end->x;
-		current_y = vector->end->y;
-		vector = vector->next;
+		current_x = self->end_x[index];
+		current_y = self->end_y[index];
 	}
 
-	printf("Cuts: %"PRId32" len %"PRId64"\n", cuts, cut_total);
-	printf("Move: %"PRId32" len %"PRId64"\n", transits, transit_total);
+	fprintf(stream, "Cuts: %"PRId32" len %"PRId64"\n", cuts, cut_total);
+	fprintf(stream, "Move: %"PRId32" len %"PRId64"\n", transits, transit_total);
 
 	return self;
 }
@@ -1,10 +1,12 @@
 #ifndef __PDF2LASER_TYPE_VECTOR_LIST_H__
 #define __PDF2LASER_TYPE_VECTOR_LIST_H__ 1
 
-#include <stdbool.h>      // for bool
-#include <stdint.h>       // for int32_t
-#include "type_point.h"   // for point_t
-#include "type_vector.h"  // for vector_t
+#include <stdbool.h>          // for bool
+#include <stddef.h>           // for size_t
+#include <stdint.h>           // for int32_t, int64_t
+#include <stdio.h>            // for FILE
+#include "type_point.h"       // for point_t
+#include "type_vector.h"      // for vector_t
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,24 +15,47 @@ extern "C" {
 }
 #endif
 
+// Vectors a list makes room for on its first append, doubled as it fills
+#define VECTOR_LIST_INITIAL_CAPACITY (1024)
+
+// Most milliseconds path_list_improve may spend on the tour of a layer
+#define VECTOR_LIST_IMPROVE_MAX (60000)
+
+// Most passes path_list_improve may make over the tour of a layer
+#define VECTOR_LIST_SWEEPS_MAX (1000)
+
+typedef enum {
+	VECTOR_LIST_PARTS_NONE = 'n',   // None: Order every path on its own
+	VECTOR_LIST_PARTS_GROUP = 'g',  // Group: Order part by part
+	VECTOR_LIST_PARTS_INNER = 'i',  // Inner: Order part by part, contours after what lies inside them
+} vector_list_parts;
+
+/**
+ * Ordered store of vectors, kept as one array per coordinate so a list of
+ * millions of cuts is four allocations rather than millions.
+ */
 typedef struct vector_list vector_list_t;
 struct vector_list {
-	vector_t *head;
-	vector_t *tail;
-	int32_t length;
+	int32_t *start_x;
+	int32_t *start_y;
+	int32_t *end_x;
+	int32_t *end_y;
+
+	size_t length;
+	size_t capacity;
 };
 
 vector_list_t *vector_list_create(void);
 vector_list_t *vector_list_destroy(vector_list_t *self);
 
-vector_list_t *vector_list_append(vector_list_t *self, vector_t *vector);
-vector_t *vector_list_remove(vector_list_t *self, vector_t *vector);
-int vector_list_contains(vector_list_t *self, vector_t *vector);
+vector_list_t *vector_list_append(vector_list_t *self, const vector_t *vector);
+vector_t *vector_list_get(vector_list_t *self, size_t index, vector_t *vector);
+
+vector_list_t *vector_list_trim_overlaps(vector_list_t *self, FILE *stream);
 
-vector_t *vector_list_find_closest(vector_list_t *list, point_t *point);
-vector_list_t *vector_list_optimize(vector_list_t *self);
+vector_list_t *vector_list_simplify(vector_list_t *self, int32_t tolerance, FILE *stream);
 
-vector_list_t *vector_list_stats(vector_list_t *self);
+vector_list_t *vector_list_stats(vector_list_t *self, const point_t *origin, FILE *stream);
 
 #ifdef __cplusplus
 };
@@ -1,8 +1,10 @@
 #include "type_vector_list_config.h"
 #include <inttypes.h>          // for PRIxPTR, PRIx32, PRId32, PRIu32
+#include <stdbool.h>           // for false
 #include <stdio.h>             // for snprintf, NULL, size_t
 #include <stdlib.h>            // for calloc, free
 #include "type_vector_list.h"  // for vector_list_create, vector_list_destroy
+#include "type_vector_set.h"   // for vector_set_destroy
 
 vector_list_config_t *vector_list_config_create(int32_t red, int32_t green, int32_t blue)
 {
@@ -11,11 +13,14 @@ vector_list_config_t *vector_list_config_create(int32_t red, int32_t green, int3
 	vector_list_config->id = vector_list_config_rgb_to_id(red, green, blue);
 
 	vector_list_config->vector_list = vector_list_create();
+	vector_list_config->vector_set = NULL;
 
 	vector_list_config->power = 0;
 	vector_list_config->speed = 0;
 	vector_list_config->multipass = 1;
 	vector_list_config->frequency = 10;
+	vector_list_config->simplify = -1;
+	vector_list_config->fallthrough = false;
 
 	return vector_list_config;
 }
@@ -28,6 +33,7 @@ vector_list_config_t *vector_list_config_shallow_clone(vector_list_config_t *sel
 	config->speed = self->speed;
 	config->multipass = self->multipass;
 	config->frequency = self->frequency;
+	config->simplify = self->simplify;
 
 	return config;
 }
@@ -35,6 +41,7 @@ vector_list_config_t *vector_list_config_shallow_clone(vector_list_config_t *sel
 vector_list_config_t *vector_list_config_destroy(vector_list_config_t *self) {
 	if (self != NULL) {
 		vector_list_destroy(self->vector_list);
+		vector_set_destroy(self->vector_set);
 	}
 
 	free(self);
@@ -51,15 +58,15 @@ char *vector_list_config_inspect(vector_list_config_t *self)
 
 char *vector_list_config_to_string(vector_list_config_t *self)
 {
-	static char *template = "Vector: pass=%"PRIu32" color=%02"PRIx32"%02"PRIx32"%02"PRIx32" speed=%"PRId32" power=%"PRId32" multipass=%"PRId32" frequency=%"PRId32"";
+	static char *template = "Vector: pass=%"PRIu32" color=%02"PRIx32"%02"PRIx32"%02"PRIx32" speed=%"PRId32" power=%"PRId32" multipass=%"PRId32" frequency=%"PRId32" simplify=%"PRId32"";
 
 	int32_t red, green, blue;
 	vector_list_config_id_to_rgb(self->id, &red, &green, &blue);
 
-	size_t s_len = 1 + snprintf(NULL, 0, template, self->index, red, green, blue, self->speed, self->power, self->multipass, self->frequency);
+	size_t s_len = 1 + snprintf(NULL, 0, template, self->index, red, green, blue, self->speed, self->power, self->multipass, self->frequency, self->simplify);
 
 	char *s = calloc(s_len, sizeof(char));
-	snprintf(s, s_len, template, self->index, red, green, blue, self->speed, self->power, self->multipass, self->frequency);
+	snprintf(s, s_len, template, self->index, red, green, blue, self->speed, self->power, self->multipass, self->frequency, self->simplify);
 	return s;
 }
 
@@ -1,8 +1,10 @@
 #ifndef __PDF2LASER_TYPE_VECTOR_LIST_CONFIG_H__
 #define __PDF2LASER_TYPE_VECTOR_LIST_CONFIG_H__ 1
 
+#include <stdbool.h>           // for bool
 #include <stdint.h>            // for int32_t, uint32_t
 #include "type_vector_list.h"  // for vector_list_t
+#include "type_vector_set.h"   // for vector_set_t
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,11 +19,16 @@ struct vector_list_config {
 	uint32_t index;
 
 	vector_list_t *vector_list;
+	vector_set_t *vector_set;
 
 	int32_t power;
 	int32_t speed;
 	int32_t multipass;
 	int32_t frequency;
+	int32_t simplify;
+
+	// Made for a colour met while tracing rather than configured, so free to be cut in any order
+	bool fallthrough;
 
 	vector_list_config_t *next;
 };
@@ -0,0 +1,422 @@
+#include "type_vector_parser.h"
+#include <math.h>                     // for ceil, fabs, fmax, lround, lroundf, sqrt
+#include <stdbool.h>                  // for bool, false, true
+#include <stddef.h>                   // for size_t, NULL
+#include <stdint.h>                   // for int32_t, uint8_t, uint32_t
+#include <stdio.h>                    // for fprintf, perror, stderr
+#include <stdlib.h>                   // for calloc, free, realloc
+#include <string.h>                   // for memcpy
+#include "type_kinematics.h"          // for kinematics_flatness
+#include "type_print_job.h"           // for print_job_t, print_job_clone_last_vector_list_config, print_job_find_vector_list_config_by_rgb
+#include "type_vector.h"              // for vector_t
+#include "type_vector_list.h"         // for vector_list_append
+#include "type_vector_list_config.h"  // for vector_list_config_t
+#include "type_vector_set.h"          // for vector_set_create, vector_set_insert
+
+vector_parser_t *vector_parser_create(print_job_t *print_job)
+{
+	vector_parser_t *vector_parser = calloc(1, sizeof(vector_parser_t));
+	if (vector_parser == NULL)
+		return NULL;
+
+	vector_parser->print_job = print_job;
+	vector_parser->current_config = NULL;
+	vector_parser->state = VECTOR_PARSER_STATE_COMMAND;
+	vector_parser->flatness = kinematics_flatness(print_job->kinematics, print_job->raster->resolution);
+
+	vector_parser->sequence_capacity = VECTOR_PARSER_SEQUENCE_NBYTES;
+	vector_parser->sequence = calloc(vector_parser->sequence_capacity, sizeof(uint8_t));
+	if (vector_parser->sequence == NULL) {
+		free(vector_parser);
+		return NULL;
+	}
+
+	return vector_parser;
+}
+
+vector_parser_t *vector_parser_destroy(vector_parser_t *self)
+{
+	if (self != NULL) {
+		free(self->sequence);
+		free(self->values);
+	}
+
+	free(self);
+	return NULL;
+}
+
+static void vector_parser_append(vector_parser_t *self, int32_t x_next, int32_t y_next)
+{
+	vector_t vector = { { self->x_current, self->y_current }, { x_next, y_next } };
+	vector_list_config_t *config = self->current_config;
+
+	// Drop exact double hits, in either direction
+	int inserted = 1;
+	if (self->print_job->vector_optimize) {
+		if (config->vector_set == NULL)
+			config->vector_set = vector_set_create();
+		inserted = (config->vector_set != NULL) ? vector_set_insert(config->vector_set, &vector) : -1;
+	}
+
+	if (inserted != 0 && vector_list_append(config->vector_list, &vector) == NULL)
+		perror("Failed to store vector");
+
+	self->x_current = x_next;
+	self->y_current = y_next;
+}
+
+/**
+ * Flatten a cubic Bezier from the current point into lines. The number of
+ * lines comes from Wang's formula, the fewest even steps in the curve
+ * parameter which keep every line within the flatness of the curve, so
+ * tight curves get many lines and gentle ones few.
+ *
+ * @param self the parser.
+ * @param control the two control points and the end point, x then y.
+ */
+static void vector_parser_curve(vector_parser_t *self, const int32_t *control)
+{
+	double x0 = self->x_current, y0 = self->y_current;
+	double x1 = control[0], y1 = control[1];
+	double x2 = control[2], y2 = control[3];
+	double x3 = control[4], y3 = control[5];
+
+	double ddx = fmax(fabs(x0 - 2 * x1 + x2), fabs(x1 - 2 * x2 + x3));
+	double ddy = fmax(fabs(y0 - 2 * y1 + y2), fabs(y1 - 2 * y2 + y3));
+	double steps = ceil(sqrt(0.75 * sqrt(ddx * ddx + ddy * ddy) / self->flatness));
+	if (steps < 1)
+		steps = 1;
+	else if (steps > VECTOR_PARSER_CURVE_STEPS)
+		steps = VECTOR_PARSER_CURVE_STEPS;
+
+	for (int32_t step = 1; step < steps; step++) {
+		double t = step / steps;
+		double u = 1 - t;
+		double x = u * u * u * x0 + 3 * u * u * t * x1 + 3 * u * t * t * x2 + t * t * t * x3;
+		double y = u * u * u * y0 + 3 * u * u * t * y1 + 3 * u * t * t * y2 + t * t * t * y3;
+
+		// Rounding bunches the points of tight curves, skip the repeats
+		int32_t x_next = (int32_t)lround(x);
+		int32_t y_next = (int32_t)lround(y);
+		if (x_next != self->x_current || y_next != self->y_current)
+			vector_parser_append(self, x_next, y_next);
+	}
+
+	if (steps == 1 || control[4] != self->x_current || control[5] != self->y_current)
+		vector_parser_append(self, control[4], control[5]);
+}
+
+static void vector_parser_end_field(vector_parser_t *self)
+{
+	if (self->digits && self->field_count < VECTOR_PARSER_FIELDS)
+		self->fields[self->field_count++] = self->negative ? -self->number : self->number;
+
+	self->number = 0;
+	self->negative = false;
+	self->digits = false;
+}
+
+/**
+ * Act on a completed record, in either protocol. Points are pairs of values,
+ * a move record starts a new line at its first point, and every other point
+ * extends the line, directly or along a curve.
+ *
+ * @param self the parser.
+ * @param command the record type.
+ * @param values the values carried by the record.
+ * @param count number of values.
+ *
+ * @return 0 if the record was understood, -1 otherwise.
+ */
+static int vector_parser_dispatch(vector_parser_t *self, char command, const int32_t *values, size_t count)
+{
+	switch (command) {
+	case 'P': {
+		if (count != 3)
+			break;
+		// Note: Colours are printed as blue, green, red by the hook
+		print_job_t *print_job = self->print_job;
+		vector_list_config_t *config = print_job_find_vector_list_config_by_rgb(print_job, values[2], values[1], values[0]);
+		if (config == NULL)
+			config = print_job_clone_last_vector_list_config(print_job, values[2], values[1], values[0]);
+		self->current_config = config;
+		return 0;
+	}
+	case 'M':
+		// Start of new line. Implicitly sets current laser position.
+		if (count < 2 || count % 2 != 0 || (count > 2 && self->current_config == NULL))
+			break;
+		self->x_start = self->x_current = values[0];
+		self->y_start = self->y_current = values[1];
+		for (size_t index = 2; index < count; index += 2)
+			vector_parser_append(self, values[index], values[index + 1]);
+		return 0;
+	case 'L':
+		if (count < 2 || count % 2 != 0 || self->current_config == NULL)
+			break;
+		for (size_t index = 0; index < count; index += 2)
+			vector_parser_append(self, values[index], values[index + 1]);
+		return 0;
+	case 'B':
+		// Curves from the current point, as control, control, end point
+		if (count == 0 || count % 6 != 0 || self->current_config == NULL)
+			break;
+		for (size_t index = 0; index < count; index += 6)
+			vector_parser_curve(self, values + index);
+		return 0;
+	case 'C':
+		// Closing statment from current point to starting point.
+		if (count % 2 != 0 || self->current_config == NULL)
+			break;
+		for (size_t index = 0; index < count; index += 2)
+			vector_parser_append(self, values[index], values[index + 1]);
+		vector_parser_append(self, self->x_start, self->y_start);
+		return 0;
+	case 'X':
+		// Only the first page is cut
+		self->state = VECTOR_PARSER_STATE_DONE;
+		return 0;
+	}
+
+	fprintf(stderr, "Malformed vector record '%c'\n", command);
+	return -1;
+}
+
+static uint32_t vector_parser_read_uint(const uint8_t *data, size_t nbytes, bool big_endian)
+{
+	uint32_t value = 0;
+	for (size_t index = 0; index < nbytes; index++) {
+		size_t shift = 8 * (big_endian ? nbytes - 1 - index : index);
+		value |= (uint32_t)data[index] << shift;
+	}
+	return value;
+}
+
+/**
+ * Decode a completed binary object sequence. The hook prints one array of
+ * numbers per record with printobject, the record type is carried in the tag
+ * of the top level object.
+ *
+ * @return 0 if the record was understood, -1 otherwise.
+ */
+static int vector_parser_dispatch_sequence(vector_parser_t *self)
+{
+	const uint8_t *sequence = self->sequence;
+	bool big_endian = (sequence[0] == 128 || sequence[0] == 130);
+	bool ieee = (sequence[0] == 128 || sequence[0] == 129);
+
+	const uint8_t *objects = sequence + self->sequence_header_size;
+	size_t objects_size = self->sequence_size - self->sequence_header_size;
+
+	if (objects_size < 8 || (objects[0] & 0x7f) != VECTOR_PARSER_OBJECT_ARRAY) {
+		fprintf(stderr, "Malformed vector sequence\n");
+		return -1;
+	}
+
+	char command = (char)objects[1];
+	size_t count = vector_parser_read_uint(objects + 2, 2, big_endian);
+	size_t offset = vector_parser_read_uint(objects + 4, 4, big_endian);
+
+	if (count > 0 && (offset > objects_size || count > (objects_size - offset) / 8)) {
+		fprintf(stderr, "Malformed vector sequence\n");
+		return -1;
+	}
+
+	if (count > self->values_capacity) {
+		int32_t *values = realloc(self->values, count * sizeof(int32_t));
+		if (values == NULL) {
+			perror("realloc failed");
+			return -1;
+		}
+		self->values = values;
+		self->values_capacity = count;
+	}
+
+	for (size_t index = 0; index < count; index++) {
+		const uint8_t *object = objects + offset + 8 * index;
+		uint32_t value = vector_parser_read_uint(object + 4, 4, big_endian);
+
+		switch (object[0] & 0x7f) {
+		case VECTOR_PARSER_OBJECT_INTEGER:
+			self->values[index] = (int32_t)value;
+			break;
+		case VECTOR_PARSER_OBJECT_REAL: {
+			float real;
+			if (!ieee && !big_endian)
+				memcpy(&real, object + 4, sizeof(real));
+			else
+				memcpy(&real, &value, sizeof(real));
+			self->values[index] = (int32_t)lroundf(real);
+			break;
+		}
+		default:
+			fprintf(stderr, "Malformed vector sequence\n");
+			return -1;
+		}
+	}
+
+	return vector_parser_dispatch(self, command, self->values, count);
+}
+
+/**
+ * Collect the bytes of a binary object sequence, growing the buffer as the
+ * header reveals how long the sequence is.
+ *
+ * @return number of bytes of str consumed.
+ */
+static size_t vector_parser_collect(vector_parser_t *self, const uint8_t *str, size_t length)
+{
+	size_t needed = self->sequence_size - self->sequence_length;
+	size_t nbytes = (length < needed) ? length : needed;
+
+	memcpy(self->sequence + self->sequence_length, str, nbytes);
+	self->sequence_length += nbytes;
+
+	if (self->sequence_length < self->sequence_size)
+		return nbytes;
+
+	if (self->state == VECTOR_PARSER_STATE_HEADER) {
+		const uint8_t *sequence = self->sequence;
+		bool big_endian = (sequence[0] == 128 || sequence[0] == 130);
+
+		// A zero count in the normal header marks the extended header
+		if (sequence[1] == 0 && self->sequence_size < 8) {
+			self->sequence_size = 8;
+			return nbytes;
+		}
+
+		self->sequence_header_size = self->sequence_size;
+		size_t total = (self->sequence_header_size == 8) ?
+			vector_parser_read_uint(sequence + 4, 4, big_endian) :
+			vector_parser_read_uint(sequence + 2, 2, big_endian);
+
+		if (total <= self->sequence_header_size) {
+			fprintf(stderr, "Malformed vector sequence\n");
+			self->state = VECTOR_PARSER_STATE_COMMAND;
+			return nbytes;
+		}
+
+		if (total > self->sequence_capacity) {
+			uint8_t *grown = realloc(self->sequence, total);
+			if (grown == NULL) {
+				perror("realloc failed");
+				self->state = VECTOR_PARSER_STATE_DONE;
+				return nbytes;
+			}
+			self->sequence = grown;
+			self->sequence_capacity = total;
+		}
+
+		self->sequence_size = total;
+		self->state = VECTOR_PARSER_STATE_SEQUENCE;
+		return nbytes;
+	}
+
+	self->state = VECTOR_PARSER_STATE_COMMAND;
+	vector_parser_dispatch_sequence(self);
+	return nbytes;
+}
+
+/**
+ * Feed a chunk of the hook's output to the parser.
+ *
+ * @param self the parser.
+ * @param str the chunk, it need not start or end on a record boundary.
+ * @param length number of bytes in the chunk.
+ *
+ * @return 0, malformed records are reported and skipped.
+ */
+int vector_parser_feed(vector_parser_t *self, const char *str, size_t length)
+{
+	for (size_t index = 0; index < length; index++) {
+		char c = str[index];
+
+		switch (self->state) {
+		case VECTOR_PARSER_STATE_COMMAND:
+			switch (c) {
+			case '\n':
+				break;
+			case 'P':
+			case 'M':
+			case 'L':
+			case 'B':
+			case 'C':
+			case 'X':
+				self->command = c;
+				self->field_count = 0;
+				self->number = 0;
+				self->negative = false;
+				self->digits = false;
+				self->state = VECTOR_PARSER_STATE_FIELDS;
+				break;
+			case (char)128:
+			case (char)129:
+			case (char)130:
+			case (char)131:
+				// Start of a binary object sequence
+				self->sequence_length = 0;
+				self->sequence_size = 4;
+				self->state = VECTOR_PARSER_STATE_HEADER;
+				index += vector_parser_collect(self, (const uint8_t *)str + index, length - index) - 1;
+				break;
+			default:
+				fprintf(stderr, "Unknown command '%c'\n", c);
+				self->state = VECTOR_PARSER_STATE_SKIP;
+				break;
+			}
+			break;
+
+		case VECTOR_PARSER_STATE_HEADER:
+		case VECTOR_PARSER_STATE_SEQUENCE:
+			index += vector_parser_collect(self, (const uint8_t *)str + index, length - index) - 1;
+			break;
+
+		case VECTOR_PARSER_STATE_FIELDS:
+			if (c >= '0' && c <= '9') {
+				self->number = self->number * 10 + (c - '0');
+				self->digits = true;
+			}
+			else if (c == '-') {
+				self->negative = true;
+			}
+			else if (c == ',') {
+				vector_parser_end_field(self);
+			}
+			else if (c == '\n') {
+				vector_parser_end_field(self);
+				self->state = VECTOR_PARSER_STATE_COMMAND;
+				vector_parser_dispatch(self, self->command, self->fields, self->field_count);
+			}
+			break;
+
+		case VECTOR_PARSER_STATE_SKIP:
+			if (c == '\n')
+				self->state = VECTOR_PARSER_STATE_COMMAND;
+			break;
+
+		case VECTOR_PARSER_STATE_DONE:
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Flush a final record which was not newline terminated.
+ */
+int vector_parser_finish(vector_parser_t *self)
+{
+	if (self->state == VECTOR_PARSER_STATE_FIELDS) {
+		vector_parser_end_field(self);
+		self->state = VECTOR_PARSER_STATE_COMMAND;
+		return vector_parser_dispatch(self, self->command, self->fields, self->field_count);
+	}
+
+	if (self->state == VECTOR_PARSER_STATE_HEADER || self->state == VECTOR_PARSER_STATE_SEQUENCE) {
+		fprintf(stderr, "Truncated vector sequence\n");
+		return -1;
+	}
+
+	return 0;
+}
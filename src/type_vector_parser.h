@@ -0,0 +1,90 @@
+#ifndef __PDF2LASER_TYPE_VECTOR_PARSER_H__
+#define __PDF2LASER_TYPE_VECTOR_PARSER_H__ 1
+
+#include <stdbool.h>                  // for bool
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for int32_t, uint8_t
+#include "type_print_job.h"           // for print_job_t
+#include "type_vector_list_config.h"  // for vector_list_config_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+typedef enum {
+	VECTOR_PARSER_STATE_COMMAND,
+	VECTOR_PARSER_STATE_FIELDS,
+	VECTOR_PARSER_STATE_SKIP,
+	VECTOR_PARSER_STATE_HEADER,
+	VECTOR_PARSER_STATE_SEQUENCE,
+	VECTOR_PARSER_STATE_DONE,
+} vector_parser_state_t;
+
+// Most fields carried by a single text record, the three points of "B"
+#define VECTOR_PARSER_FIELDS 6
+
+// Most lines a single curve is flattened into
+#define VECTOR_PARSER_CURVE_STEPS 1024
+
+// Initial size of the binary object sequence buffer, grown on demand
+#define VECTOR_PARSER_SEQUENCE_NBYTES (8192)
+
+// Binary object sequence types used by the compact protocol
+#define VECTOR_PARSER_OBJECT_INTEGER 1
+#define VECTOR_PARSER_OBJECT_REAL 2
+#define VECTOR_PARSER_OBJECT_ARRAY 9
+
+/**
+ * Incremental parser for the records printed by the stroke hook of the
+ * prologue. Input is fed in whatever chunks ghostscript hands to its stdout
+ * callback, a record may be split across any number of them, and segments
+ * are appended to the vector list of their colour as soon as a record is
+ * complete.
+ *
+ * Records are either newline terminated text, or binary object sequences
+ * holding one array of numbers when the compact protocol is in use.
+ */
+typedef struct vector_parser vector_parser_t;
+struct vector_parser {
+	print_job_t *print_job;
+	vector_list_config_t *current_config;
+
+	vector_parser_state_t state;
+	char command;
+	int32_t fields[VECTOR_PARSER_FIELDS];
+	int32_t field_count;
+	int32_t number;
+	bool negative;
+	bool digits;
+
+	uint8_t *sequence;
+	size_t sequence_capacity;
+	size_t sequence_length;
+	size_t sequence_size;
+	size_t sequence_header_size;
+
+	int32_t *values;
+	size_t values_capacity;
+
+	double flatness;
+
+	int32_t x_start;
+	int32_t y_start;
+	int32_t x_current;
+	int32_t y_current;
+};
+
+vector_parser_t *vector_parser_create(print_job_t *print_job);
+vector_parser_t *vector_parser_destroy(vector_parser_t *self);
+
+int vector_parser_feed(vector_parser_t *self, const char *str, size_t length);
+int vector_parser_finish(vector_parser_t *self);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+#include "type_vector_set.h"
+#include <stdbool.h>      // for bool, false, true
+#include <stddef.h>       // for size_t, NULL
+#include <stdint.h>       // for uint8_t
+#include <stdlib.h>       // for calloc, free
+#include "type_vector.h"  // for vector_t, vector_equal, vector_hash, vector_normalize
+
+vector_set_t *vector_set_create(void)
+{
+	vector_set_t *vector_set = calloc(1, sizeof(vector_set_t));
+	if (vector_set == NULL)
+		return NULL;
+
+	vector_set->slots = NULL;
+	vector_set->used = NULL;
+	vector_set->length = 0;
+	vector_set->capacity = 0;
+
+	return vector_set;
+}
+
+vector_set_t *vector_set_destroy(vector_set_t *self)
+{
+	if (self == NULL)
+		return NULL;
+
+	free(self->slots);
+	free(self->used);
+	free(self);
+
+	return NULL;
+}
+
+/**
+ * Find the slot holding a normalized vector, or the empty slot it would go.
+ */
+static size_t vector_set_probe(vector_set_t *self, const vector_t *key)
+{
+	size_t mask = self->capacity - 1;
+	size_t slot = (size_t)vector_hash(key) & mask;
+
+	while (self->used[slot] && !vector_equal(&self->slots[slot], key))
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+static bool vector_set_grow(vector_set_t *self)
+{
+	size_t capacity = (self->capacity > 0) ? self->capacity * 2 : VECTOR_SET_INITIAL_CAPACITY;
+
+	vector_t *slots = calloc(capacity, sizeof(vector_t));
+	uint8_t *used = calloc(capacity, sizeof(uint8_t));
+	if (slots == NULL || used == NULL) {
+		free(slots);
+		free(used);
+		return false;
+	}
+
+	vector_set_t grown = { slots, used, 0, capacity };
+	for (size_t index = 0; index < self->capacity; index += 1) {
+		if (!self->used[index])
+			continue;
+		size_t slot = vector_set_probe(&grown, &self->slots[index]);
+		grown.slots[slot] = self->slots[index];
+		grown.used[slot] = 1;
+	}
+
+	free(self->slots);
+	free(self->used);
+
+	self->slots = slots;
+	self->used = used;
+	self->capacity = capacity;
+
+	return true;
+}
+
+/**
+ * Add a vector to the set.
+ *
+ * @return 1 if the vector was added, 0 if it, or its reverse, was already a
+ * member, -1 if the set could not grow.
+ */
+int vector_set_insert(vector_set_t *self, const vector_t *vector)
+{
+	// Keep the load factor at or below one half
+	if (2 * (self->length + 1) > self->capacity && !vector_set_grow(self))
+		return -1;
+
+	vector_t key = *vector;
+	vector_normalize(&key);
+	size_t slot = vector_set_probe(self, &key);
+	if (self->used[slot])
+		return 0;
+
+	self->slots[slot] = key;
+	self->used[slot] = 1;
+	self->length += 1;
+
+	return 1;
+}
+
+bool vector_set_contains(vector_set_t *self, const vector_t *vector)
+{
+	if (self->length == 0)
+		return false;
+
+	vector_t key = *vector;
+	vector_normalize(&key);
+	return self->used[vector_set_probe(self, &key)];
+}
@@ -0,0 +1,42 @@
+#ifndef __PDF2LASER_TYPE_VECTOR_SET_H__
+#define __PDF2LASER_TYPE_VECTOR_SET_H__ 1
+
+#include <stdbool.h>      // for bool
+#include <stddef.h>       // for size_t
+#include <stdint.h>       // for uint8_t
+#include "type_vector.h"  // for vector_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#if 0
+}
+#endif
+
+// Slots a set makes room for on its first insert, a power of two
+#define VECTOR_SET_INITIAL_CAPACITY (1024)
+
+/**
+ * Open addressing hash set of vectors. A vector and its reverse are the same
+ * member, endpoints are compared exactly.
+ */
+typedef struct vector_set vector_set_t;
+struct vector_set {
+	vector_t *slots;
+	uint8_t *used;
+
+	size_t length;
+	size_t capacity;
+};
+
+vector_set_t *vector_set_create(void);
+vector_set_t *vector_set_destroy(vector_set_t *self);
+
+int vector_set_insert(vector_set_t *self, const vector_t *vector);
+bool vector_set_contains(vector_set_t *self, const vector_t *vector);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __PDF2LASER_TEST_H__
+#define __PDF2LASER_TEST_H__ 1
+
+#include <stdbool.h>  // for bool
+#include <stdio.h>    // for fprintf, stderr
+#include <stdlib.h>   // for EXIT_FAILURE, EXIT_SUCCESS
+
+/**
+ * Checks shared by the test programs. A failed check is reported and fails
+ * the program, the checks after it still run.
+ */
+static int test_failures = 0;
+
+#define CHECK(condition) test_check((condition), #condition, __FILE__, __LINE__)
+
+static inline bool test_check(bool passed, const char *condition, const char *file, int line)
+{
+	if (!passed) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+		test_failures += 1;
+	}
+	return passed;
+}
+
+static inline int test_result(void)
+{
+	return (test_failures > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include <pthread.h>          // for pthread_create, pthread_join, pthread_t
+#include <stddef.h>           // for NULL, size_t
+#include <stdint.h>           // for int32_t, uint8_t
+#include <string.h>           // for memset
+#include "type_band_queue.h"  // for band_queue_t, band_queue_acquire, band_queue_close, band_queue_create, band_queue_destroy, band_queue_peek, band_queue_publish, band_queue_release
+#include "test.h"             // for CHECK, test_result
+
+// More bands than the queue holds, so the producer has to wait
+#define TEST_BANDS (64)
+#define TEST_BAND_SIZE (256)
+
+static void *test_produce(void *arg)
+{
+	band_queue_t *band_queue = arg;
+
+	for (int32_t band = 0; band < TEST_BANDS; band += 1) {
+		uint8_t *data = band_queue_acquire(band_queue);
+		if (data == NULL)
+			break;
+		memset(data, band, TEST_BAND_SIZE);
+		band_queue_publish(band_queue, band * 10, band + 1);
+	}
+
+	band_queue_close(band_queue);
+
+	return NULL;
+}
+
+/*
+ * Bands come out whole and in the order they went in, and the queue drains
+ * before the consumer sees it closed.
+ */
+static void test_order(void)
+{
+	band_queue_t *band_queue = band_queue_create(3, TEST_BAND_SIZE);
+	if (!CHECK(band_queue != NULL))
+		return;
+
+	pthread_t producer;
+	if (!CHECK(pthread_create(&producer, NULL, test_produce, band_queue) == 0)) {
+		band_queue_destroy(band_queue);
+		return;
+	}
+
+	int32_t expected = 0;
+	int32_t y, rows;
+	uint8_t *data;
+	while ((data = band_queue_peek(band_queue, &y, &rows)) != NULL) {
+		CHECK(y == expected * 10);
+		CHECK(rows == expected + 1);
+
+		bool whole = true;
+		for (size_t index = 0; index < TEST_BAND_SIZE; index += 1)
+			whole = whole && data[index] == (uint8_t)expected;
+		CHECK(whole);
+
+		band_queue_release(band_queue);
+		expected += 1;
+	}
+
+	pthread_join(producer, NULL);
+	CHECK(expected == TEST_BANDS);
+
+	band_queue_destroy(band_queue);
+}
+
+/*
+ * A closed queue hands out no more slots.
+ */
+static void test_closed(void)
+{
+	band_queue_t *band_queue = band_queue_create(1, TEST_BAND_SIZE);
+	if (!CHECK(band_queue != NULL))
+		return;
+
+	band_queue_close(band_queue);
+	CHECK(band_queue_acquire(band_queue) == NULL);
+
+	int32_t y, rows;
+	CHECK(band_queue_peek(band_queue, &y, &rows) == NULL);
+
+	band_queue_destroy(band_queue);
+}
+
+int main(void)
+{
+	test_order();
+	test_closed();
+
+	return test_result();
+}
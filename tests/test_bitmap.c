@@ -0,0 +1,33 @@
+#include <stdint.h>       // for int32_t, uint8_t
+#include "type_bitmap.h"  // for bitmap_t, bitmap_create, bitmap_destroy, bitmap_row
+#include "test.h"         // for CHECK, test_result
+
+/*
+ * Rows are a raster apart, however wide the page, and start out blank.
+ */
+static void test_rows(void)
+{
+	bitmap_t *bitmap = bitmap_create(10, 4, 16);
+	if (!CHECK(bitmap != NULL))
+		return;
+
+	for (int32_t y = 0; y < bitmap->height; y += 1)
+		CHECK(bitmap_row(bitmap, y) == bitmap->data + y * 16);
+
+	bool blank = true;
+	for (int32_t index = 0; index < bitmap->height * bitmap->raster; index += 1)
+		blank = blank && bitmap->data[index] == 0;
+	CHECK(blank);
+
+	bitmap_row(bitmap, 3)[15] = 0xff;
+	CHECK(bitmap->data[63] == 0xff);
+
+	CHECK(bitmap_destroy(bitmap) == NULL);
+}
+
+int main(void)
+{
+	test_rows();
+
+	return test_result();
+}
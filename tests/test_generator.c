@@ -0,0 +1,373 @@
+#include <inttypes.h>                 // for PRIu32
+#include <stdbool.h>                  // for bool, false, true
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for int32_t, int64_t, uint32_t
+#include <stdio.h>                    // for fclose, fdopen, fputs, open_memstream, snprintf, FILE
+#include <stdlib.h>                   // for free, mkstemp
+#include <string.h>                   // for memcmp, strstr
+#include <unistd.h>                   // for unlink
+#include "pdf2laser_generator.h"      // for generate_prologue, generate_vector
+#include "type_print_job.h"           // for print_job_t, print_job_append_new_vector_list_config, print_job_clone_last_vector_list_config, print_job_create, print_job_destroy, PRINT_JOB_MODE_RASTER, PRINT_JOB_MODE_VECTOR
+#include "type_path_list.h"           // for PATH_LIST_ORDER_CANDIDATES
+#include "type_point.h"               // for point_t, point_distance_squared
+#include "type_vector.h"              // for vector_t
+#include "type_vector_list.h"         // for vector_list_t, vector_list_append, vector_list_get, VECTOR_LIST_SWEEPS_MAX
+#include "type_vector_list_config.h"  // for vector_list_config_t, vector_list_config_rgb_to_id
+#include "test.h"                     // for CHECK, test_result
+
+/*
+ * Write the leading comments of a postscript file.
+ *
+ * @param path a mkstemp template, filled in with the file's path.
+ */
+static bool test_write_ps(char *path, const char *content)
+{
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return false;
+
+	FILE *file = fdopen(fd, "w");
+	if (file == NULL)
+		return false;
+	fputs(content, file);
+	fclose(file);
+
+	return true;
+}
+
+/*
+ * The page is placed by a prologue run ahead of the postscript, taking its
+ * size from the bounding box and moving its corner to the origin.
+ */
+static void test_prologue_bounding_box(void)
+{
+	char path[] = "/tmp/pdf2laser-test-XXXXXX";
+	if (!CHECK(test_write_ps(path, "%!PS-Adobe-3.0\n%%PageBoundingBox: 10 20 310 220\n%%EndComments\n")))
+		return;
+
+	print_job_t *print_job = print_job_create();
+	char *prologue = generate_prologue(print_job, path);
+	if (CHECK(prologue != NULL)) {
+		CHECK(print_job->width == 300);
+		CHECK(print_job->height == 200);
+		CHECK(strstr(prologue, "/setpagedevice{pop}def\n") != NULL);
+		CHECK(strstr(prologue, "-10 -20 translate\n") != NULL);
+	}
+
+	free(prologue);
+	print_job_destroy(print_job);
+	unlink(path);
+}
+
+/*
+ * Only a job with a vector pass hooks stroke, a raster only job lets it paint.
+ */
+static void test_prologue_stroke_hook(void)
+{
+	char path[] = "/tmp/pdf2laser-test-XXXXXX";
+	if (!CHECK(test_write_ps(path, "%!PS-Adobe-3.0\n%%EndComments\n")))
+		return;
+
+	print_job_t *print_job = print_job_create();
+
+	print_job->mode = PRINT_JOB_MODE_RASTER;
+	char *prologue = generate_prologue(print_job, path);
+	if (CHECK(prologue != NULL))
+		CHECK(strstr(prologue, "/stroke {") == NULL);
+	free(prologue);
+
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+	prologue = generate_prologue(print_job, path);
+	if (CHECK(prologue != NULL))
+		CHECK(strstr(prologue, "/stroke {") != NULL);
+	free(prologue);
+
+	print_job_destroy(print_job);
+	unlink(path);
+}
+
+/*
+ * Configured colours are matched by looking the stroke colour up in a
+ * dictionary holding their ids.
+ */
+static void test_prologue_colour_dictionary(void)
+{
+	char path[] = "/tmp/pdf2laser-test-XXXXXX";
+	if (!CHECK(test_write_ps(path, "%!PS-Adobe-3.0\n%%EndComments\n")))
+		return;
+
+	print_job_t *print_job = print_job_create();
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+	print_job->vector_fallthrough = false;
+	print_job_append_new_vector_list_config(print_job, 255, 0, 0);
+	print_job_append_new_vector_list_config(print_job, 0, 0, 255);
+
+	char *prologue = generate_prologue(print_job, path);
+	if (CHECK(prologue != NULL)) {
+		char put[64];
+		CHECK(strstr(prologue, "/pdf2laser_colors 2 dict def") != NULL);
+		snprintf(put, sizeof(put), " //pdf2laser_colors %"PRIu32" true put", vector_list_config_rgb_to_id(255, 0, 0));
+		CHECK(strstr(prologue, put) != NULL);
+		snprintf(put, sizeof(put), " //pdf2laser_colors %"PRIu32" true put", vector_list_config_rgb_to_id(0, 0, 255));
+		CHECK(strstr(prologue, put) != NULL);
+		CHECK(strstr(prologue, "known ") != NULL);
+	}
+
+	free(prologue);
+	print_job_destroy(print_job);
+	unlink(path);
+}
+
+/*
+ * A vector job of several layers of scattered short cuts, all but the first
+ * made by fallthrough, optimized on the given number of threads.
+ */
+static print_job_t *test_vector_job(uint32_t threads, uint32_t sweeps)
+{
+	print_job_t *print_job = print_job_create();
+	if (print_job == NULL)
+		return NULL;
+
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+	print_job->threads = threads;
+	print_job->vector_sweeps = sweeps;
+
+	uint32_t seed = 5;
+	for (int32_t layer = 0; layer < 6; layer++) {
+		vector_list_config_t *vector_list_config = (layer == 0) ?
+			print_job_append_new_vector_list_config(print_job, 0, 0, 0) :
+			print_job_clone_last_vector_list_config(print_job, 40 * layer, 0, 0);
+		if (vector_list_config == NULL)
+			return print_job_destroy(print_job);
+
+		for (size_t index = 0; index < 200; index++) {
+			int32_t coordinates[4];
+			for (size_t coordinate = 0; coordinate < 4; coordinate++) {
+				seed = seed * 1103515245 + 12345;
+				coordinates[coordinate] = (int32_t)((seed >> 8) % 5000);
+			}
+			vector_t vector = {
+				{ coordinates[0] + 1000 * layer, coordinates[1] },
+				{ coordinates[0] + 1000 * layer + coordinates[2] / 50, coordinates[1] + coordinates[3] / 50 },
+			};
+			vector_list_append(vector_list_config->vector_list, &vector);
+		}
+	}
+
+	return print_job;
+}
+
+/*
+ * Render the vector pass of a job, returning the HPGL written.
+ */
+static char *test_generate_vector(print_job_t *print_job, size_t *length)
+{
+	char *hpgl = NULL;
+	FILE *hpgl_fh = open_memstream(&hpgl, length);
+	if (hpgl_fh == NULL)
+		return NULL;
+
+	int rc = generate_vector(print_job, hpgl_fh);
+	fclose(hpgl_fh);
+	if (rc != 0) {
+		free(hpgl);
+		return NULL;
+	}
+
+	return hpgl;
+}
+
+/*
+ * Optimizing layers on a pool of threads cuts exactly what a single thread
+ * does, in the same order, without tour improvement, with improvement cut
+ * short after a sweep, and with it run until no move helps.
+ */
+static void test_vector_threads(void)
+{
+	static const uint32_t sweeps[] = { 0, 1, VECTOR_LIST_SWEEPS_MAX };
+	for (size_t index = 0; index < sizeof(sweeps) / sizeof(sweeps[0]); index++) {
+		print_job_t *serial = test_vector_job(1, sweeps[index]);
+		print_job_t *pooled = test_vector_job(4, sweeps[index]);
+		if (!CHECK(serial != NULL && pooled != NULL)) {
+			print_job_destroy(serial);
+			print_job_destroy(pooled);
+			return;
+		}
+
+		size_t serial_length = 0, pooled_length = 0;
+		char *serial_hpgl = test_generate_vector(serial, &serial_length);
+		char *pooled_hpgl = test_generate_vector(pooled, &pooled_length);
+		if (CHECK(serial_hpgl != NULL && pooled_hpgl != NULL)) {
+			if (CHECK(serial_length > 0 && serial_length == pooled_length))
+				CHECK(memcmp(serial_hpgl, pooled_hpgl, serial_length) == 0);
+		}
+
+		bool same_order = true;
+		vector_list_config_t *pooled_config = pooled->configs;
+		for (vector_list_config_t *serial_config = serial->configs;
+		     serial_config != NULL;
+		     serial_config = serial_config->next, pooled_config = pooled_config->next) {
+			same_order = same_order && pooled_config != NULL && pooled_config->id == serial_config->id;
+		}
+		CHECK(same_order && pooled_config == NULL);
+
+		free(serial_hpgl);
+		free(pooled_hpgl);
+		print_job_destroy(serial);
+		print_job_destroy(pooled);
+	}
+}
+
+/*
+ * Scatter short cuts over a square of the page into a layer.
+ */
+static void test_scatter(vector_list_config_t *vector_list_config, int32_t x, int32_t y, uint32_t seed)
+{
+	for (size_t index = 0; index < 30; index++) {
+		int32_t coordinates[4];
+		for (size_t coordinate = 0; coordinate < 4; coordinate++) {
+			seed = seed * 1103515245 + 12345;
+			coordinates[coordinate] = (int32_t)((seed >> 8) % 500);
+		}
+		vector_t vector = {
+			{ x + coordinates[0], y + coordinates[1] },
+			{ x + coordinates[0] + coordinates[2] / 10, y + coordinates[1] + coordinates[3] / 10 },
+		};
+		vector_list_append(vector_list_config->vector_list, &vector);
+	}
+}
+
+/*
+ * Layers the user configured keep their order, a run of fallthrough layers
+ * spread apart is cut nearest first, and every layer starts with one of the cuts nearest
+ * where the one before left the head.
+ */
+static void test_vector_layer_order(void)
+{
+	static const int32_t places[][3] = {
+		// Red, and where the layer lies
+		{ 10, 9000, 0 },
+		{ 20, 0, 3000 },
+		{ 30, 8000, 0 },
+		{ 40, 2000, 3000 },
+		{ 50, 5000, 3000 },
+	};
+	static const int32_t cut_order[] = { 10, 20, 40, 50, 30 };
+
+	print_job_t *print_job = print_job_create();
+	if (!CHECK(print_job != NULL))
+		return;
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+
+	bool created = true;
+	for (size_t index = 0; index < sizeof(places) / sizeof(*places); index++) {
+		vector_list_config_t *vector_list_config = (index < 2) ?
+			print_job_append_new_vector_list_config(print_job, places[index][0], 0, 0) :
+			print_job_clone_last_vector_list_config(print_job, places[index][0], 0, 0);
+		created = created && vector_list_config != NULL;
+		if (vector_list_config != NULL)
+			test_scatter(vector_list_config, places[index][1], places[index][2], (uint32_t)index + 1);
+	}
+
+	size_t length = 0;
+	char *hpgl = (CHECK(created)) ? test_generate_vector(print_job, &length) : NULL;
+	if (CHECK(hpgl != NULL)) {
+		bool ordered = true;
+		bool seeded = true;
+		point_t origin = { 0, 0 };
+		size_t index = 0;
+		for (vector_list_config_t *vector_list_config = print_job->configs;
+		     vector_list_config != NULL;
+		     vector_list_config = vector_list_config->next, index += 1) {
+			vector_list_t *vector_list = vector_list_config->vector_list;
+			ordered = ordered && index < sizeof(cut_order) / sizeof(*cut_order) && vector_list_config->index == index &&
+				vector_list_config->id == vector_list_config_rgb_to_id(cut_order[index], 0, 0);
+
+			// The first cut is one of those the greedy order weighs from there
+			vector_t vector;
+			vector_list_get(vector_list, 0, &vector);
+			int64_t first = point_distance_squared(&vector.start, &origin);
+			size_t nearer = 0;
+			for (size_t other = 0; other < vector_list->length; other++) {
+				vector_list_get(vector_list, other, &vector);
+				int64_t start = point_distance_squared(&vector.start, &origin);
+				int64_t end = point_distance_squared(&vector.end, &origin);
+				nearer += (((start < end) ? start : end) < first) ? 1 : 0;
+			}
+			seeded = seeded && nearer < PATH_LIST_ORDER_CANDIDATES;
+			vector_list_get(vector_list, vector_list->length - 1, &vector);
+			origin = vector.end;
+		}
+		CHECK(ordered && index == sizeof(cut_order) / sizeof(*cut_order));
+		CHECK(seeded);
+	}
+
+	free(hpgl);
+	print_job_destroy(print_job);
+}
+
+/*
+ * A run of fallthrough layers is cut in the order the machine model finds
+ * quickest: a cut square to the way the head comes in costs a turn, so one
+ * a little further on in line with it is reached first.
+ */
+static void test_vector_layer_time(void)
+{
+	static const int32_t cuts[][5] = {
+		// Red, and the layer's one cut
+		{ 10, 0, 0, 0, 0 },
+		{ 20, 1000, 0, 1000, 300 },
+		{ 30, 1100, 0, 1400, 0 },
+	};
+	static const int32_t cut_order[] = { 10, 30, 20 };
+
+	print_job_t *print_job = print_job_create();
+	if (!CHECK(print_job != NULL))
+		return;
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+	print_job->kinematics->speed = 1000;
+	print_job->kinematics->acceleration = 10000;
+	print_job->kinematics->corner = 20;
+	print_job->kinematics->resolution = 600;
+
+	bool created = true;
+	for (size_t index = 0; index < sizeof(cuts) / sizeof(*cuts); index++) {
+		vector_list_config_t *vector_list_config = (index == 0) ?
+			print_job_append_new_vector_list_config(print_job, cuts[index][0], 0, 0) :
+			print_job_clone_last_vector_list_config(print_job, cuts[index][0], 0, 0);
+		created = created && vector_list_config != NULL;
+		if (vector_list_config != NULL && index > 0) {
+			vector_t vector = { { cuts[index][1], cuts[index][2] }, { cuts[index][3], cuts[index][4] } };
+			vector_list_append(vector_list_config->vector_list, &vector);
+		}
+	}
+
+	size_t length = 0;
+	char *hpgl = (CHECK(created)) ? test_generate_vector(print_job, &length) : NULL;
+	if (CHECK(hpgl != NULL)) {
+		bool ordered = true;
+		size_t index = 0;
+		for (vector_list_config_t *vector_list_config = print_job->configs;
+		     vector_list_config != NULL;
+		     vector_list_config = vector_list_config->next, index += 1) {
+			ordered = ordered && index < sizeof(cut_order) / sizeof(*cut_order) &&
+				vector_list_config->id == vector_list_config_rgb_to_id(cut_order[index], 0, 0);
+		}
+		CHECK(ordered && index == sizeof(cut_order) / sizeof(*cut_order));
+	}
+
+	free(hpgl);
+	print_job_destroy(print_job);
+}
+
+int main(void)
+{
+	test_prologue_bounding_box();
+	test_prologue_stroke_hook();
+	test_prologue_colour_dictionary();
+	test_vector_threads();
+	test_vector_layer_order();
+	test_vector_layer_time();
+
+	return test_result();
+}
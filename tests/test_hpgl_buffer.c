@@ -0,0 +1,92 @@
+#include <inttypes.h>          // for PRId32
+#include <stdbool.h>           // for bool, true
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t, uint32_t, INT32_MAX, INT32_MIN
+#include <stdio.h>             // for fclose, fprintf, open_memstream, fread, rewind, tmpfile, FILE
+#include <stdlib.h>            // for free, malloc
+#include <string.h>            // for memcmp
+#include "type_hpgl_buffer.h"  // for hpgl_buffer_t, hpgl_buffer_add_pair, hpgl_buffer_append, hpgl_buffer_clear, hpgl_buffer_create, hpgl_buffer_destroy, hpgl_buffer_write, HPGL_BUFFER_INITIAL_CAPACITY
+#include "test.h"              // for CHECK, test_result
+
+// Pairs added, enough for the buffer to grow past its first allocation
+#define TEST_PAIRS (HPGL_BUFFER_INITIAL_CAPACITY / 8)
+
+/*
+ * Numbers of every width, both signs, and the ends of the range.
+ */
+static int32_t test_number(uint32_t *seed, size_t index)
+{
+	static const int32_t edges[] = { 0, -1, 9, 10, -10, INT32_MAX, INT32_MIN, 1000000000, -999999999 };
+	if (index < sizeof(edges) / sizeof(*edges))
+		return edges[index];
+
+	*seed = *seed * 1103515245 + 12345;
+	uint32_t digits = *seed % 10;
+	int32_t number = (int32_t)(*seed >> 1);
+	for (uint32_t digit = 0; digit < digits; digit++)
+		number /= 10;
+	return number;
+}
+
+/*
+ * Rendered commands, grown well past the first allocation, match what
+ * printf would write for them, and are written out unchanged.
+ */
+static void test_add_pair(void)
+{
+	char *expected = NULL;
+	size_t expected_length = 0;
+	FILE *expected_fh = open_memstream(&expected, &expected_length);
+	hpgl_buffer_t *hpgl_buffer = hpgl_buffer_create();
+	if (!CHECK(expected_fh != NULL && hpgl_buffer != NULL)) {
+		if (expected_fh != NULL)
+			fclose(expected_fh);
+		free(expected);
+		hpgl_buffer_destroy(hpgl_buffer);
+		return;
+	}
+
+	uint32_t seed = 3;
+	bool added = true;
+	added = added && hpgl_buffer_append(hpgl_buffer, "IN;", 3) != NULL;
+	fprintf(expected_fh, "IN;");
+	for (size_t index = 0; index < TEST_PAIRS; index++) {
+		const char *prefix = (index % 3 == 0) ? ";PU" : (index % 3 == 1) ? "PD" : "";
+		int32_t first = test_number(&seed, 2 * index);
+		int32_t second = test_number(&seed, 2 * index + 1);
+		added = added && hpgl_buffer_add_pair(hpgl_buffer, prefix, first, second) != NULL;
+		fprintf(expected_fh, "%s%"PRId32",%"PRId32, prefix, first, second);
+	}
+	fclose(expected_fh);
+
+	CHECK(added);
+	CHECK(hpgl_buffer->length > HPGL_BUFFER_INITIAL_CAPACITY);
+	if (CHECK(hpgl_buffer->length == expected_length))
+		CHECK(memcmp(hpgl_buffer->data, expected, expected_length) == 0);
+
+	FILE *written = tmpfile();
+	char *read_back = malloc(expected_length + 1);
+	if (CHECK(written != NULL && read_back != NULL)) {
+		CHECK(hpgl_buffer_write(hpgl_buffer, written));
+		rewind(written);
+		CHECK(fread(read_back, 1, expected_length + 1, written) == expected_length);
+		CHECK(memcmp(read_back, expected, expected_length) == 0);
+	}
+	if (written != NULL)
+		fclose(written);
+	free(read_back);
+
+	CHECK(hpgl_buffer_clear(hpgl_buffer) != NULL && hpgl_buffer->length == 0);
+	CHECK(hpgl_buffer_add_pair(hpgl_buffer, "PA", -7, 42) != NULL);
+	CHECK(hpgl_buffer->length == 7 && memcmp(hpgl_buffer->data, "PA-7,42", 7) == 0);
+
+	free(expected);
+	hpgl_buffer_destroy(hpgl_buffer);
+}
+
+int main(void)
+{
+	test_add_pair();
+
+	return test_result();
+}
@@ -0,0 +1,85 @@
+#include <math.h>             // for fabs
+#include <stdbool.h>          // for bool, true
+#include "type_kinematics.h"  // for kinematics_t, kinematics_create, kinematics_destroy, kinematics_flatness, kinematics_link_time, kinematics_transit_time
+#include "type_point.h"       // for point_t
+#include "test.h"             // for CHECK, test_result
+
+/*
+ * Longer transits never take less time, short hops never reach top speed,
+ * and the time is continuous where they start to.
+ */
+static void test_transit_time(void)
+{
+	kinematics_t *kinematics = kinematics_create();
+	if (!CHECK(kinematics != NULL))
+		return;
+
+	CHECK(kinematics_transit_time(kinematics, 0.0) == 0.0);
+
+	bool monotonic = true;
+	double previous = 0.0;
+	for (double distance = 0.5; distance < 2000.0; distance *= 1.1) {
+		double time = kinematics_transit_time(kinematics, distance);
+		monotonic = monotonic && time > previous;
+		monotonic = monotonic && time >= distance / kinematics->speed;
+		previous = time;
+	}
+	CHECK(monotonic);
+
+	double speed = kinematics->speed, acceleration = kinematics->acceleration;
+	double knee = speed * speed / acceleration;
+	CHECK(fabs(kinematics_transit_time(kinematics, knee * (1 - 1e-9)) - kinematics_transit_time(kinematics, knee)) < 1e-6);
+
+	kinematics_destroy(kinematics);
+}
+
+/*
+ * Going straight on costs only the transit, turning back costs a corner.
+ */
+static void test_link_time(void)
+{
+	kinematics_t *kinematics = kinematics_create();
+	if (!CHECK(kinematics != NULL))
+		return;
+
+	point_t from_inner = { 0, 0 }, from = { 1000, 0 }, to = { 2000, 0 };
+	point_t ahead = { 3000, 0 }, back = { 1000, 0 }, aside = { 2000, 1000 };
+	double transit = kinematics_transit_time(kinematics, 1000 * 25.4 / kinematics->resolution);
+
+	double straight = kinematics_link_time(kinematics, &from_inner, &from, &to, &ahead);
+	double reversal = kinematics_link_time(kinematics, &from_inner, &from, &to, &back);
+	double turn = kinematics_link_time(kinematics, &from_inner, &from, &to, &aside);
+
+	CHECK(fabs(straight - transit) < 1e-9);
+	CHECK(fabs(reversal - transit - kinematics->corner / 1000.0) < 1e-9);
+	CHECK(straight < turn && turn < reversal);
+
+	kinematics->corner = 0;
+	CHECK(kinematics_link_time(kinematics, &from_inner, &from, &to, &back) == straight);
+
+	kinematics_destroy(kinematics);
+}
+
+/*
+ * Curves are never flattened finer than half a device unit.
+ */
+static void test_flatness(void)
+{
+	kinematics_t *kinematics = kinematics_create();
+	if (!CHECK(kinematics != NULL))
+		return;
+
+	CHECK(kinematics_flatness(kinematics, 75) == 0.5);
+	CHECK(kinematics_flatness(kinematics, 1200) >= kinematics_flatness(kinematics, 600));
+
+	kinematics_destroy(kinematics);
+}
+
+int main(void)
+{
+	test_transit_time();
+	test_link_time();
+	test_flatness();
+
+	return test_result();
+}
@@ -0,0 +1,518 @@
+#include <math.h>              // for hypot, lround, sin
+#include <stdbool.h>           // for bool, false, true
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t, uint32_t
+#include <stdio.h>             // for fclose, fflush, fopen, open_memstream, FILE
+#include <stdlib.h>            // for calloc, free
+#include <string.h>            // for strstr
+#include "type_kinematics.h"   // for kinematics_t, kinematics_create, kinematics_destroy, kinematics_link_time
+#include "type_path_list.h"    // for path_list_t, path_list_add_point, path_list_append_path, path_list_begin, path_list_chain, path_list_create, path_list_closed, path_list_destroy, path_list_from_vector_list, path_list_improve, path_list_optimize, path_list_optimize_parts, path_list_points, path_list_rotate, path_list_simplify
+#include "type_point.h"        // for point_t
+#include "type_vector.h"       // for vector_t, vector_equal, vector_flip
+#include "type_vector_list.h"  // for vector_list_t, vector_list_append, vector_list_create, vector_list_destroy, vector_list_get
+#include "test.h"              // for CHECK, test_result
+
+/*
+ * A vector list holding count vectors, each given as x, y to x, y.
+ */
+static vector_list_t *test_vector_list(const int32_t (*coordinates)[4], size_t count)
+{
+	vector_list_t *vector_list = vector_list_create();
+	if (vector_list == NULL)
+		return NULL;
+
+	for (size_t index = 0; index < count; index++) {
+		vector_t vector = {
+			{ coordinates[index][0], coordinates[index][1] },
+			{ coordinates[index][2], coordinates[index][3] },
+		};
+		if (vector_list_append(vector_list, &vector) == NULL)
+			return vector_list_destroy(vector_list);
+	}
+
+	return vector_list;
+}
+
+/*
+ * Whether the lines of the paths are the vectors of the list, each cut once
+ * in either direction.
+ */
+static bool test_covers(path_list_t *path_list, vector_list_t *vector_list)
+{
+	bool *used = calloc(vector_list->length, sizeof(bool));
+	if (used == NULL)
+		return false;
+
+	bool covers = true;
+	size_t lines = 0;
+	for (size_t path = 0; path < path_list->length; path++) {
+		for (size_t point = path_list->offsets[path] + 1; point < path_list->offsets[path + 1]; point++) {
+			vector_t line = {
+				{ path_list->x[point - 1], path_list->y[point - 1] },
+				{ path_list->x[point], path_list->y[point] },
+			};
+			vector_t reverse = line;
+			vector_flip(&reverse);
+
+			bool found = false;
+			for (size_t index = 0; index < vector_list->length && !found; index++) {
+				vector_t vector;
+				vector_list_get(vector_list, index, &vector);
+				found = !used[index] && (vector_equal(&vector, &line) || vector_equal(&vector, &reverse));
+				used[index] = used[index] || found;
+			}
+			covers = covers && found;
+			lines += 1;
+		}
+	}
+
+	free(used);
+	return covers && lines == vector_list->length;
+}
+
+/*
+ * Vectors sharing endpoints are chained into the fewest paths, a square
+ * given out of order into one closed path, and a cross into two open ones.
+ */
+static void test_chain(void)
+{
+	static const int32_t coordinates[][4] = {
+		{ 10, 10, 10, 0 },
+		{ 0, 0, 10, 0 },
+		{ 100, 100, 100, 90 },
+		{ 0, 10, 0, 0 },
+		{ 110, 100, 100, 100 },
+		{ 10, 10, 0, 10 },
+		{ 100, 100, 90, 100 },
+		{ 100, 110, 100, 100 },
+	};
+
+	vector_list_t *vector_list = test_vector_list(coordinates, sizeof(coordinates) / sizeof(*coordinates));
+	if (!CHECK(vector_list != NULL))
+		return;
+
+	path_list_t *path_list = path_list_chain(vector_list);
+	if (CHECK(path_list != NULL)) {
+		CHECK(path_list->length == 3);
+		CHECK(test_covers(path_list, vector_list));
+
+		size_t closed = 0;
+		for (size_t path = 0; path < path_list->length; path++)
+			closed += path_list_closed(path_list, path) ? 1 : 0;
+		CHECK(closed == 1);
+	}
+
+	path_list_destroy(path_list);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Short vectors scattered over the page, in no useful order.
+ */
+static vector_list_t *test_scatter(size_t count, uint32_t seed)
+{
+	vector_list_t *vector_list = vector_list_create();
+	if (vector_list == NULL)
+		return NULL;
+
+	for (size_t index = 0; index < count; index++) {
+		int32_t coordinates[4];
+		for (size_t coordinate = 0; coordinate < 4; coordinate++) {
+			seed = seed * 1103515245 + 12345;
+			coordinates[coordinate] = (int32_t)((seed >> 8) % 10000);
+		}
+		vector_t vector = {
+			{ coordinates[0], coordinates[1] },
+			{ coordinates[0] + coordinates[2] / 50, coordinates[1] + coordinates[3] / 50 },
+		};
+		if (vector_list_append(vector_list, &vector) == NULL)
+			return vector_list_destroy(vector_list);
+	}
+
+	return vector_list;
+}
+
+/*
+ * End of a path, and the point next to it, going in or coming out.
+ */
+static void test_end(path_list_t *path_list, size_t path, bool last, point_t *point, point_t *inner)
+{
+	size_t first = path_list->offsets[path];
+	size_t end = path_list->offsets[path + 1] - 1;
+	size_t at = last ? end : first;
+	size_t next = (first == end) ? at : (last ? end - 1 : first + 1);
+
+	point->x = path_list->x[at];
+	point->y = path_list->y[at];
+	inner->x = path_list->x[next];
+	inner->y = path_list->y[next];
+}
+
+/*
+ * Time the machine model estimates for the transits of an ordered list.
+ */
+static double test_transit(path_list_t *path_list, kinematics_t *kinematics, const point_t *origin)
+{
+	point_t from = *origin, from_inner = *origin;
+	double transit = 0;
+
+	for (size_t path = 0; path < path_list->length; path++) {
+		point_t to, to_inner;
+		test_end(path_list, path, false, &to, &to_inner);
+		transit += kinematics_link_time(kinematics, &from_inner, &from, &to, &to_inner);
+		test_end(path_list, path, true, &from, &from_inner);
+	}
+
+	return transit;
+}
+
+/*
+ * Whether two paths hold the same points in the same order.
+ */
+static bool test_same_path(path_list_t *path_list, size_t path, path_list_t *other, size_t other_path)
+{
+	size_t points = path_list_points(path_list, path);
+	if (points != path_list_points(other, other_path))
+		return false;
+
+	bool same = true;
+	for (size_t point = 0; point < points; point++) {
+		size_t index = path_list->offsets[path] + point;
+		size_t other_index = other->offsets[other_path] + point;
+		same = same && path_list->x[index] == other->x[other_index] && path_list->y[index] == other->y[other_index];
+	}
+	return same;
+}
+
+/*
+ * The greedy order weighs the nearest paths with the machine model, so a
+ * path straight ahead beats a nearer one behind the head, unless turning
+ * costs nothing.
+ */
+static void test_optimize_model(void)
+{
+	static const int32_t coordinates[][4] = {
+		{ 0, 0, 1000, 0 },
+		{ 990, 0, 900, 0 },
+		{ 1030, 0, 1100, 0 },
+	};
+
+	vector_list_t *vector_list = test_vector_list(coordinates, sizeof(coordinates) / sizeof(*coordinates));
+	kinematics_t *kinematics = kinematics_create();
+	path_list_t *paths = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	point_t origin = { 0, 0 };
+
+	if (CHECK(paths != NULL && kinematics != NULL && paths->length == 3)) {
+		kinematics->speed = 1000;
+		kinematics->acceleration = 10000;
+		kinematics->corner = 20;
+		kinematics->resolution = 600;
+
+		path_list_t *path_list = path_list_optimize(paths, kinematics, &origin);
+		if (CHECK(path_list != NULL && path_list->length == 3)) {
+			CHECK(test_covers(path_list, vector_list));
+			CHECK(path_list->x[path_list->offsets[1]] == 1030);
+		}
+		path_list_destroy(path_list);
+
+		kinematics->corner = 0;
+		path_list = path_list_optimize(paths, kinematics, &origin);
+		if (CHECK(path_list != NULL && path_list->length == 3))
+			CHECK(path_list->x[path_list->offsets[1]] == 990);
+		path_list_destroy(path_list);
+	}
+
+	path_list_destroy(paths);
+	kinematics_destroy(kinematics);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Improving a greedy order shortens its transit, keeps every cut, and with
+ * keep_last leaves the last path where it is.
+ */
+static void test_improve(void)
+{
+	vector_list_t *vector_list = test_scatter(300, 11);
+	kinematics_t *kinematics = kinematics_create();
+	path_list_t *paths = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	FILE *stream = fopen("/dev/null", "w");
+	point_t origin = { 0, 0 };
+
+	path_list_t *greedy = (paths != NULL) ? path_list_optimize(paths, kinematics, &origin) : NULL;
+	if (CHECK(greedy != NULL && kinematics != NULL && stream != NULL)) {
+		double transit = test_transit(greedy, kinematics, &origin);
+
+		path_list_t *improved = path_list_improve(greedy, 0, 60000, kinematics, &origin, false, stream);
+		if (CHECK(improved != NULL)) {
+			CHECK(improved->length == greedy->length);
+			CHECK(test_covers(improved, vector_list));
+			CHECK(test_transit(improved, kinematics, &origin) < transit);
+		}
+		path_list_destroy(improved);
+
+		improved = path_list_improve(greedy, 0, 60000, kinematics, &origin, true, stream);
+		if (CHECK(improved != NULL)) {
+			CHECK(test_covers(improved, vector_list));
+			CHECK(test_transit(improved, kinematics, &origin) <= transit);
+			CHECK(test_same_path(improved, improved->length - 1, greedy, greedy->length - 1));
+		}
+		path_list_destroy(improved);
+	}
+
+	if (stream != NULL)
+		fclose(stream);
+	path_list_destroy(greedy);
+	path_list_destroy(paths);
+	kinematics_destroy(kinematics);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Improving for a number of sweeps, without a time budget, stops after them
+ * and comes out the same every time.
+ */
+static void test_improve_sweeps(void)
+{
+	vector_list_t *vector_list = test_scatter(300, 11);
+	kinematics_t *kinematics = kinematics_create();
+	path_list_t *paths = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	point_t origin = { 0, 0 };
+	char *report = NULL;
+	size_t report_length = 0;
+	FILE *stream = open_memstream(&report, &report_length);
+
+	path_list_t *greedy = (paths != NULL) ? path_list_optimize(paths, kinematics, &origin) : NULL;
+	if (CHECK(greedy != NULL && kinematics != NULL && stream != NULL)) {
+		double transit = test_transit(greedy, kinematics, &origin);
+
+		path_list_t *first = path_list_improve(greedy, 1, 0, kinematics, &origin, false, stream);
+		path_list_t *second = path_list_improve(greedy, 1, 0, kinematics, &origin, false, stream);
+		fflush(stream);
+		if (CHECK(first != NULL && second != NULL)) {
+			CHECK(test_covers(first, vector_list));
+			CHECK(test_transit(first, kinematics, &origin) < transit);
+			CHECK(strstr(report, "(sweeps spent)") != NULL);
+
+			bool same = first->length == second->length;
+			for (size_t index = 0; same && index < first->length; index++)
+				same = test_same_path(first, index, second, index);
+			CHECK(same);
+		}
+		path_list_destroy(first);
+		path_list_destroy(second);
+	}
+
+	if (stream != NULL)
+		fclose(stream);
+	free(report);
+	path_list_destroy(greedy);
+	path_list_destroy(paths);
+	kinematics_destroy(kinematics);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * A closed path is entered at the point nearest the head, and gone round in
+ * the direction which turns least onto it, unless it has to end where it
+ * does.
+ */
+static void test_rotate(void)
+{
+	static const int32_t coordinates[][4] = {
+		{ 0, 0, 1000, 0 },
+		{ 1000, 0, 1000, 1000 },
+		{ 1000, 1000, 0, 1000 },
+		{ 0, 1000, 0, 0 },
+	};
+
+	vector_list_t *vector_list = test_vector_list(coordinates, sizeof(coordinates) / sizeof(*coordinates));
+	kinematics_t *kinematics = kinematics_create();
+	path_list_t *path_list = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	path_list_t *kept = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	point_t origin = { 1100, 1200 };
+
+	if (CHECK(path_list != NULL && kept != NULL && kinematics != NULL)) {
+		double transit = test_transit(path_list, kinematics, &origin);
+
+		if (CHECK(path_list_rotate(path_list, kinematics, &origin, false) != NULL)) {
+			CHECK(path_list->length == 1 && path_list_closed(path_list, 0));
+			CHECK(path_list->x[0] == 1000 && path_list->y[0] == 1000);
+			CHECK(path_list->x[1] == 1000 && path_list->y[1] == 0);
+			CHECK(test_covers(path_list, vector_list));
+			CHECK(test_transit(path_list, kinematics, &origin) < transit);
+		}
+
+		if (CHECK(path_list_rotate(kept, kinematics, &origin, true) != NULL))
+			CHECK(kept->x[0] == 0 && kept->y[0] == 0);
+	}
+
+	path_list_destroy(kept);
+	path_list_destroy(path_list);
+	kinematics_destroy(kinematics);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Furthest right point of a path, which tells the paths of a layout apart.
+ */
+static int32_t test_right(path_list_t *path_list, size_t path)
+{
+	int32_t right = path_list->x[path_list->offsets[path]];
+	for (size_t point = path_list->offsets[path]; point < path_list->offsets[path + 1]; point++)
+		right = (path_list->x[point] > right) ? path_list->x[point] : right;
+	return right;
+}
+
+/*
+ * Parts are cut whole, and with inner_first a contour only after everything
+ * inside it, even when the head starts on the contour.
+ */
+static void test_optimize_parts(void)
+{
+	static const int32_t coordinates[][4] = {
+		// A part, its contour, a hole, and a line inside it
+		{ 0, 0, 1000, 0 },
+		{ 1000, 0, 1000, 1000 },
+		{ 1000, 1000, 0, 1000 },
+		{ 0, 1000, 0, 0 },
+		{ 400, 400, 600, 400 },
+		{ 600, 400, 600, 600 },
+		{ 600, 600, 400, 600 },
+		{ 400, 600, 400, 400 },
+		{ 200, 200, 300, 300 },
+		// Another part, further away
+		{ 2000, 0, 3000, 0 },
+		{ 3000, 0, 3000, 1000 },
+		{ 3000, 1000, 2000, 1000 },
+		{ 2000, 1000, 2000, 0 },
+	};
+
+	vector_list_t *vector_list = test_vector_list(coordinates, sizeof(coordinates) / sizeof(*coordinates));
+	kinematics_t *kinematics = kinematics_create();
+	path_list_t *paths = (vector_list != NULL) ? path_list_from_vector_list(vector_list) : NULL;
+	point_t origin = { 0, 0 };
+
+	if (!CHECK(paths != NULL && kinematics != NULL && paths->length == 4)) {
+		path_list_destroy(paths);
+		kinematics_destroy(kinematics);
+		vector_list_destroy(vector_list);
+		return;
+	}
+
+	for (int inner_first = 0; inner_first < 2; inner_first++) {
+		path_list_t *path_list = path_list_optimize_parts(paths, kinematics, inner_first, &origin);
+		if (!CHECK(path_list != NULL && path_list->length == 4 && path_list->group != NULL)) {
+			path_list_destroy(path_list);
+			continue;
+		}
+		CHECK(test_covers(path_list, vector_list));
+
+		size_t position[4];
+		for (size_t path = 0; path < 4; path++) {
+			int32_t right = test_right(path_list, path);
+			position[(right == 300) ? 0 : (right == 600) ? 1 : (right == 1000) ? 2 : 3] = path;
+		}
+
+		// The other part is only visited once the first is done, and never
+		// shares a group with it
+		CHECK(position[3] == 3);
+		for (size_t path = 0; path < 3; path++)
+			CHECK(path_list->group[position[3]] != path_list->group[position[path]]);
+
+		if (inner_first) {
+			// The contour is a barrier, in a group of its own
+			CHECK(position[2] > position[0] && position[2] > position[1]);
+			CHECK(path_list->group[position[2]] != path_list->group[position[0]]);
+		} else {
+			CHECK(position[2] == 0);
+			CHECK(path_list->group[position[0]] == path_list->group[position[2]]);
+			CHECK(path_list->group[position[1]] == path_list->group[position[2]]);
+		}
+
+		path_list_destroy(path_list);
+	}
+
+	path_list_destroy(paths);
+	kinematics_destroy(kinematics);
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Distance from a point to the nearest line of a path.
+ */
+static double test_deviation(path_list_t *path_list, size_t path, int32_t x, int32_t y)
+{
+	double nearest = -1;
+	for (size_t point = path_list->offsets[path] + 1; point < path_list->offsets[path + 1]; point++) {
+		double ax = path_list->x[point - 1], ay = path_list->y[point - 1];
+		double dx = path_list->x[point] - ax, dy = path_list->y[point] - ay;
+		double length = dx * dx + dy * dy;
+		double t = (length > 0) ? ((x - ax) * dx + (y - ay) * dy) / length : 0;
+		t = (t < 0) ? 0 : (t > 1) ? 1 : t;
+		double distance = hypot(x - (ax + t * dx), y - (ay + t * dy));
+		nearest = (nearest < 0 || distance < nearest) ? distance : nearest;
+	}
+	return nearest;
+}
+
+/*
+ * Simplifying drops repeats and straight runs exactly, and with a tolerance
+ * leaves every dropped point within it of the path, keeping both ends.
+ */
+static void test_simplify(void)
+{
+	// A wavy line, a repeated point, and a straight run
+	path_list_t *original = path_list_create();
+	if (!CHECK(original != NULL && path_list_begin(original) != NULL)) {
+		path_list_destroy(original);
+		return;
+	}
+	for (int32_t step = 0; step <= 200; step++)
+		path_list_add_point(original, 10 * step, (int32_t)lround(40 * sin(step / 7.0) + 15 * sin(step / 2.3)));
+	path_list_add_point(original, 2000, 500);
+	path_list_add_point(original, 2000, 500);
+	for (int32_t step = 1; step <= 10; step++)
+		path_list_add_point(original, 2000 + 100 * step, 500 + 30 * step);
+
+	for (int32_t tolerance = 0; tolerance <= 20; tolerance += 5) {
+		path_list_t *path_list = path_list_create();
+		if (!CHECK(path_list != NULL && path_list_append_path(path_list, original, 0, false) != NULL)) {
+			path_list_destroy(path_list);
+			break;
+		}
+
+		size_t removed = 0;
+		if (CHECK(path_list_simplify(path_list, tolerance, &removed) != NULL)) {
+			size_t points = path_list_points(path_list, 0);
+			CHECK(points + removed == path_list_points(original, 0));
+			CHECK(removed >= 10 && (tolerance == 0 || removed > 100));
+
+			size_t last = original->point_count - 1;
+			CHECK(path_list->x[0] == original->x[0] && path_list->y[0] == original->y[0]);
+			CHECK(path_list->x[points - 1] == original->x[last] && path_list->y[points - 1] == original->y[last]);
+
+			bool within = true;
+			for (size_t point = 0; point < original->point_count; point++)
+				within = within && test_deviation(path_list, 0, original->x[point], original->y[point]) <= tolerance;
+			CHECK(within);
+		}
+
+		path_list_destroy(path_list);
+	}
+
+	path_list_destroy(original);
+}
+
+int main(void)
+{
+	test_chain();
+	test_optimize_model();
+	test_improve();
+	test_improve_sweeps();
+	test_rotate();
+	test_optimize_parts();
+	test_simplify();
+
+	return test_result();
+}
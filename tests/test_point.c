@@ -0,0 +1,59 @@
+#include <stdbool.h>      // for bool, true
+#include <stdint.h>       // for int32_t, int64_t, INT32_MAX
+#include "type_point.h"   // for point_t, point_compare, point_distance_squared, point_equal, point_hash, POINT_HASH_SEED
+#include "type_vector.h"  // for vector_t, vector_equal, vector_hash, vector_normalize
+#include "test.h"         // for CHECK, test_result
+
+/*
+ * Points order by x then y, and equal points hash alike.
+ */
+static void test_compare(void)
+{
+	point_t a = { -5, 7 }, b = { -5, 8 }, c = { 3, -100 }, same = { -5, 7 };
+
+	CHECK(point_compare(&a, &b) < 0 && point_compare(&b, &a) > 0);
+	CHECK(point_compare(&b, &c) < 0 && point_compare(&c, &a) > 0);
+	CHECK(point_compare(&a, &same) == 0 && point_equal(&a, &same));
+	CHECK(!point_equal(&a, &b));
+	CHECK(point_hash(&a, POINT_HASH_SEED) == point_hash(&same, POINT_HASH_SEED));
+	CHECK(point_hash(&a, POINT_HASH_SEED) != point_hash(&b, POINT_HASH_SEED));
+}
+
+/*
+ * Squared distances are exact in integers, out to points 2^31 - 1 apart on
+ * each axis.
+ */
+static void test_distance_squared(void)
+{
+	point_t a = { 3, -4 }, origin = { 0, 0 };
+	CHECK(point_distance_squared(&a, &origin) == 25);
+	CHECK(point_distance_squared(&origin, &a) == 25);
+
+	point_t low = { -INT32_MAX / 2 - 1, -INT32_MAX / 2 - 1 }, high = { INT32_MAX / 2, INT32_MAX / 2 };
+	int64_t span = (int64_t)INT32_MAX;
+	CHECK(point_distance_squared(&low, &high) == 2 * span * span);
+}
+
+/*
+ * A vector and its reverse normalize to the same vector, and so hash alike.
+ */
+static void test_vector_normalize(void)
+{
+	vector_t vector = { { 10, 20 }, { -30, 40 } };
+	vector_t reverse = { { -30, 40 }, { 10, 20 } };
+
+	CHECK(!vector_equal(&vector, &reverse));
+	CHECK(vector_normalize(&vector));
+	CHECK(!vector_normalize(&reverse));
+	CHECK(vector_equal(&vector, &reverse));
+	CHECK(vector_hash(&vector) == vector_hash(&reverse));
+}
+
+int main(void)
+{
+	test_compare();
+	test_distance_squared();
+	test_vector_normalize();
+
+	return test_result();
+}
@@ -0,0 +1,34 @@
+#include <stddef.h>          // for NULL
+#include "type_print_job.h"  // for print_job_t, print_job_create, print_job_destroy, print_job_has_raster, print_job_has_vector
+#include "test.h"            // for CHECK, test_result
+
+/*
+ * Each job mode asks for the passes it runs, and only those.
+ */
+static void test_modes(void)
+{
+	print_job_t *print_job = print_job_create();
+	if (!CHECK(print_job != NULL))
+		return;
+
+	print_job->mode = PRINT_JOB_MODE_VECTOR;
+	CHECK(!print_job_has_raster(print_job));
+	CHECK(print_job_has_vector(print_job));
+
+	print_job->mode = PRINT_JOB_MODE_RASTER;
+	CHECK(print_job_has_raster(print_job));
+	CHECK(!print_job_has_vector(print_job));
+
+	print_job->mode = PRINT_JOB_MODE_COMBINED;
+	CHECK(print_job_has_raster(print_job));
+	CHECK(print_job_has_vector(print_job));
+
+	print_job_destroy(print_job);
+}
+
+int main(void)
+{
+	test_modes();
+
+	return test_result();
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>           // for fclose, fopen, fread, FILE
+#include <stdlib.h>          // for free
+#include <string.h>          // for memcmp, strlen
+#include <unistd.h>          // for close, pipe, write, lseek, SEEK_SET
+#include "config.h"          // for HAVE_MEMFD_CREATE
+#include "pdf2laser_util.h"  // for pdf2laser_copyfd, pdf2laser_fd_path, pdf2laser_memfd_create
+#include "test.h"            // for CHECK, test_result
+
+static const char content[] = "%PDF-1.4 intermediate job file\n";
+
+/*
+ * An anonymous file reads back through its /dev/fd path like any other.
+ */
+static void test_memfd(void)
+{
+#ifdef HAVE_MEMFD_CREATE
+	int fd = pdf2laser_memfd_create("test");
+	if (!CHECK(fd >= 0))
+		return;
+
+	CHECK(write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+
+	char *path = pdf2laser_fd_path(fd);
+	FILE *file = fopen(path, "r");
+	if (CHECK(file != NULL)) {
+		char buffer[sizeof(content)] = { 0 };
+		CHECK(fread(buffer, 1, sizeof(buffer), file) == strlen(content));
+		CHECK(memcmp(buffer, content, strlen(content)) == 0);
+		fclose(file);
+	}
+
+	free(path);
+	close(fd);
+#endif
+}
+
+/*
+ * A stream whose size is not known up front is copied whole.
+ */
+static void test_copyfd(void)
+{
+	int fds[2];
+	if (!CHECK(pipe(fds) == 0))
+		return;
+
+	CHECK(write(fds[1], content, strlen(content)) == (ssize_t)strlen(content));
+	close(fds[1]);
+
+	FILE *target = tmpfile();
+	if (CHECK(target != NULL)) {
+		CHECK(pdf2laser_copyfd(fileno(target), fds[0]) == 0);
+
+		char buffer[sizeof(content)] = { 0 };
+		lseek(fileno(target), 0, SEEK_SET);
+		CHECK(read(fileno(target), buffer, sizeof(buffer)) == (ssize_t)strlen(content));
+		CHECK(memcmp(buffer, content, strlen(content)) == 0);
+		fclose(target);
+	}
+
+	close(fds[0]);
+}
+
+int main(void)
+{
+	test_memfd();
+	test_copyfd();
+
+	return test_result();
+}
@@ -0,0 +1,109 @@
+#include <stdbool.h>           // for bool, false, true
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t, int64_t, uint32_t, INT64_MAX
+#include "type_point.h"        // for point_t, point_distance_squared
+#include "type_vector.h"       // for vector_t
+#include "type_vector_grid.h"  // for vector_grid_t, vector_grid_create, vector_grid_destroy, vector_grid_nearest, vector_grid_take_closest
+#include "type_vector_list.h"  // for vector_list_t, vector_list_append, vector_list_create, vector_list_destroy, vector_list_get
+#include "test.h"              // for CHECK, test_result
+
+// Vectors scattered over the page, and how many neighbours are asked for
+#define TEST_VECTORS 2000
+#define TEST_NEIGHBOURS 8
+
+static int32_t test_coordinate(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (int32_t)((*seed >> 8) % 10000);
+}
+
+/*
+ * Distance from point to the nearer endpoint of a vector.
+ */
+static int64_t test_distance(vector_list_t *vector_list, size_t index, const point_t *point)
+{
+	vector_t vector;
+	vector_list_get(vector_list, index, &vector);
+	int64_t start = point_distance_squared(&vector.start, point);
+	int64_t end = point_distance_squared(&vector.end, point);
+	return (start < end) ? start : end;
+}
+
+/*
+ * Taking the closest vector from where the last one ended, and asking for
+ * the nearest few, agree with a brute force search of what is left.
+ */
+static void test_nearest(void)
+{
+	vector_list_t *vector_list = vector_list_create();
+	if (!CHECK(vector_list != NULL))
+		return;
+
+	uint32_t seed = 7;
+	for (size_t index = 0; index < TEST_VECTORS; index++) {
+		vector_t vector;
+		vector.start.x = test_coordinate(&seed);
+		vector.start.y = test_coordinate(&seed);
+		vector.end.x = vector.start.x + test_coordinate(&seed) / 50;
+		vector.end.y = vector.start.y - test_coordinate(&seed) / 50;
+		vector_list_append(vector_list, &vector);
+	}
+
+	vector_grid_t *vector_grid = vector_grid_create(vector_list);
+	if (!CHECK(vector_grid != NULL)) {
+		vector_list_destroy(vector_list);
+		return;
+	}
+
+	static bool taken[TEST_VECTORS];
+	point_t point = { 0, 0 };
+	size_t index;
+	bool reverse;
+	size_t count = 0;
+	bool nearest = true;
+	bool closest = true;
+
+	while (vector_grid_take_closest(vector_grid, &point, &index, &reverse)) {
+		int64_t best = INT64_MAX;
+		for (size_t other = 0; other < TEST_VECTORS; other++) {
+			int64_t distance = taken[other] ? INT64_MAX : test_distance(vector_list, other, &point);
+			best = (distance < best) ? distance : best;
+		}
+		closest = closest && !taken[index] && test_distance(vector_list, index, &point) == best;
+		taken[index] = true;
+		count += 1;
+
+		vector_t vector;
+		vector_list_get(vector_list, index, &vector);
+		point = reverse ? vector.start : vector.end;
+
+		// Every vector left is at least as far as the furthest found
+		size_t indices[TEST_NEIGHBOURS];
+		size_t found = vector_grid_nearest(vector_grid, &point, TEST_NEIGHBOURS, indices);
+		size_t left = TEST_VECTORS - count;
+		nearest = nearest && found == ((left < TEST_NEIGHBOURS) ? left : TEST_NEIGHBOURS);
+		if (found > 0 && nearest) {
+			int64_t furthest = test_distance(vector_list, indices[found - 1], &point);
+			for (size_t other = 0; other < TEST_VECTORS; other++) {
+				bool listed = false;
+				for (size_t position = 0; position < found; position++)
+					listed = listed || indices[position] == other;
+				nearest = nearest && (taken[other] || listed || test_distance(vector_list, other, &point) >= furthest);
+			}
+		}
+	}
+
+	CHECK(count == TEST_VECTORS);
+	CHECK(closest);
+	CHECK(nearest);
+
+	vector_grid_destroy(vector_grid);
+	vector_list_destroy(vector_list);
+}
+
+int main(void)
+{
+	test_nearest();
+
+	return test_result();
+}
@@ -0,0 +1,103 @@
+#include <stdbool.h>           // for bool, true
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for int32_t
+#include <stdio.h>             // for fclose, fopen, FILE
+#include "type_vector.h"       // for vector_t
+#include "type_vector_list.h"  // for vector_list_t, vector_list_append, vector_list_create, vector_list_destroy, vector_list_get, vector_list_trim_overlaps, VECTOR_LIST_INITIAL_CAPACITY
+#include "test.h"              // for CHECK, test_result
+
+/*
+ * The columns grow past their first allocation, keeping every vector.
+ */
+static void test_append_grows(void)
+{
+	vector_list_t *vector_list = vector_list_create();
+	if (!CHECK(vector_list != NULL))
+		return;
+
+	size_t length = 3 * VECTOR_LIST_INITIAL_CAPACITY + 1;
+	for (size_t index = 0; index < length; index++) {
+		int32_t value = (int32_t)index;
+		vector_t vector = { { value, -value }, { value + 1, 2 * value } };
+		if (!CHECK(vector_list_append(vector_list, &vector) != NULL))
+			break;
+	}
+
+	CHECK(vector_list->length == length);
+	CHECK(vector_list->capacity >= length);
+
+	bool kept = true;
+	for (size_t index = 0; index < vector_list->length; index++) {
+		int32_t value = (int32_t)index;
+		vector_t vector;
+		vector_list_get(vector_list, index, &vector);
+		kept = kept && vector.start.x == value && vector.start.y == -value &&
+			vector.end.x == value + 1 && vector.end.y == 2 * value;
+	}
+	CHECK(kept);
+
+	vector_list_destroy(vector_list);
+}
+
+/*
+ * Overlapping vectors on one line are trimmed to their union, keeping their
+ * order and direction, while vectors on other lines, or which only touch,
+ * are left whole.
+ */
+static void test_trim_overlaps(void)
+{
+	static const int32_t before[][4] = {
+		{ 0, 0, 100, 0 },
+		{ 0, 10, 100, 10 },
+		{ 50, 0, 150, 0 },
+		{ 120, 0, 130, 0 },
+		{ 250, 0, 150, 0 },
+		{ 0, 0, 30, 30 },
+		{ 20, 20, 10, 10 },
+	};
+	static const int32_t after[][4] = {
+		{ 0, 0, 100, 0 },
+		{ 0, 10, 100, 10 },
+		{ 100, 0, 150, 0 },
+		{ 250, 0, 150, 0 },
+		{ 0, 0, 30, 30 },
+	};
+
+	vector_list_t *vector_list = vector_list_create();
+	FILE *stream = fopen("/dev/null", "w");
+	if (!CHECK(vector_list != NULL && stream != NULL)) {
+		vector_list_destroy(vector_list);
+		if (stream != NULL)
+			fclose(stream);
+		return;
+	}
+
+	for (size_t index = 0; index < sizeof(before) / sizeof(*before); index++) {
+		vector_t vector = { { before[index][0], before[index][1] }, { before[index][2], before[index][3] } };
+		vector_list_append(vector_list, &vector);
+	}
+
+	vector_list_t *trimmed = vector_list_trim_overlaps(vector_list, stream);
+	if (CHECK(trimmed != NULL) && CHECK(trimmed->length == sizeof(after) / sizeof(*after))) {
+		bool same = true;
+		for (size_t index = 0; index < trimmed->length; index++) {
+			vector_t vector;
+			vector_list_get(trimmed, index, &vector);
+			same = same && vector.start.x == after[index][0] && vector.start.y == after[index][1] &&
+				vector.end.x == after[index][2] && vector.end.y == after[index][3];
+		}
+		CHECK(same);
+	}
+
+	vector_list_destroy(trimmed);
+	vector_list_destroy(vector_list);
+	fclose(stream);
+}
+
+int main(void)
+{
+	test_append_grows();
+	test_trim_overlaps();
+
+	return test_result();
+}
@@ -0,0 +1,252 @@
+#include <math.h>                     // for hypot
+#include <stdbool.h>                  // for bool, false, true
+#include <stddef.h>                   // for size_t, NULL
+#include <stdint.h>                   // for int32_t, uint8_t, uint32_t
+#include <string.h>                   // for memcpy, strlen
+#include "type_kinematics.h"          // for kinematics_flatness
+#include "type_point.h"               // for point_equal
+#include "type_print_job.h"           // for print_job_t, print_job_append_new_vector_list_config, print_job_create, print_job_destroy
+#include "type_vector.h"              // for vector_t, vector_equal
+#include "type_vector_list.h"         // for vector_list_t, vector_list_get
+#include "type_vector_list_config.h"  // for vector_list_config_t
+#include "type_vector_parser.h"       // for vector_parser_t, vector_parser_create, vector_parser_destroy, vector_parser_feed, vector_parser_finish, VECTOR_PARSER_CURVE_STEPS, VECTOR_PARSER_OBJECT_ARRAY, VECTOR_PARSER_OBJECT_INTEGER, VECTOR_PARSER_OBJECT_REAL
+#include "test.h"                     // for CHECK, test_result
+
+/*
+ * Parse the output of the stroke hook into a new job with one red config,
+ * feeding it chunk bytes at a time.
+ */
+static print_job_t *test_parse(const char *str, size_t length, size_t chunk)
+{
+	print_job_t *print_job = print_job_create();
+	if (print_job == NULL)
+		return NULL;
+	print_job_append_new_vector_list_config(print_job, 255, 0, 0);
+
+	vector_parser_t *vector_parser = vector_parser_create(print_job);
+	if (vector_parser == NULL)
+		return print_job_destroy(print_job);
+
+	for (size_t index = 0; index < length; index += chunk)
+		vector_parser_feed(vector_parser, str + index, (length - index < chunk) ? length - index : chunk);
+	vector_parser_finish(vector_parser);
+
+	vector_parser_destroy(vector_parser);
+	return print_job;
+}
+
+/*
+ * Whether two vector lists hold the same vectors in the same order.
+ */
+static bool test_same_vectors(vector_list_t *vector_list, vector_list_t *other)
+{
+	if (vector_list->length != other->length)
+		return false;
+
+	for (size_t index = 0; index < vector_list->length; index++) {
+		vector_t vector, other_vector;
+		vector_list_get(vector_list, index, &vector);
+		vector_list_get(other, index, &other_vector);
+		if (!vector_equal(&vector, &other_vector))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Records split across the chunks of ghostscript's stdout parse as if they
+ * arrived whole, the last one needing no newline.
+ */
+static void test_text_chunks(void)
+{
+	const char *str = "P0,0,255\nM10,20\nL30,-40\nL50,60\nC\nM-5,5\nL7,7";
+	size_t length = strlen(str);
+
+	print_job_t *whole = test_parse(str, length, length);
+	print_job_t *split = test_parse(str, length, 1);
+	if (CHECK(whole != NULL && split != NULL)) {
+		vector_list_t *vector_list = whole->configs->vector_list;
+		CHECK(vector_list->length == 4);
+
+		vector_t vector;
+		vector_list_get(vector_list, 1, &vector);
+		CHECK(vector.start.x == 30 && vector.start.y == -40 && vector.end.x == 50 && vector.end.y == 60);
+		vector_list_get(vector_list, 2, &vector);
+		CHECK(vector.end.x == 10 && vector.end.y == 20);
+
+		CHECK(test_same_vectors(vector_list, split->configs->vector_list));
+	}
+
+	print_job_destroy(whole);
+	print_job_destroy(split);
+}
+
+/*
+ * Store an unsigned value of nbytes in either byte order.
+ */
+static void test_write_uint(uint8_t *data, uint32_t value, size_t nbytes, bool big_endian)
+{
+	for (size_t index = 0; index < nbytes; index++) {
+		size_t shift = 8 * (big_endian ? nbytes - 1 - index : index);
+		data[index] = (uint8_t)(value >> shift);
+	}
+}
+
+/*
+ * Build the binary object sequence printobject writes for an array of
+ * numbers tagged with its record type.
+ *
+ * @return Size of the sequence in bytes.
+ */
+static size_t test_sequence(uint8_t *data, char tag, const int32_t *values, size_t count,
+                            bool big_endian, bool extended, bool real)
+{
+	size_t header_size = extended ? 8 : 4;
+	size_t size = header_size + 8 + 8 * count;
+
+	data[0] = big_endian ? 128 : 129;
+	if (extended) {
+		data[1] = 0;
+		test_write_uint(data + 2, 1, 2, big_endian);
+		test_write_uint(data + 4, (uint32_t)size, 4, big_endian);
+	} else {
+		data[1] = 1;
+		test_write_uint(data + 2, (uint32_t)size, 2, big_endian);
+	}
+
+	uint8_t *objects = data + header_size;
+	objects[0] = VECTOR_PARSER_OBJECT_ARRAY;
+	objects[1] = (uint8_t)tag;
+	test_write_uint(objects + 2, (uint32_t)count, 2, big_endian);
+	test_write_uint(objects + 4, 8, 4, big_endian);
+
+	for (size_t index = 0; index < count; index++) {
+		uint8_t *object = objects + 8 + 8 * index;
+		uint32_t value = (uint32_t)values[index];
+		if (real) {
+			float number = (float)values[index];
+			memcpy(&value, &number, sizeof(value));
+		}
+		object[0] = real ? VECTOR_PARSER_OBJECT_REAL : VECTOR_PARSER_OBJECT_INTEGER;
+		object[1] = 0;
+		test_write_uint(object + 2, 0, 2, big_endian);
+		test_write_uint(object + 4, value, 4, big_endian);
+	}
+
+	return size;
+}
+
+/*
+ * The compact protocol decodes integers and reals, in either byte order and
+ * with either header, however its sequences are split.
+ */
+static void test_binary_sequences(void)
+{
+	static const int32_t colour[] = { 0, 0, 255 };
+	static const int32_t move[] = { 10, 20 };
+	static const int32_t line[] = { 30, -40, 50, 60 };
+	static const int32_t close[] = { -70, 80 };
+
+	uint8_t str[256];
+	size_t length = 0;
+	length += test_sequence(str + length, 'P', colour, 3, true, false, false);
+	length += test_sequence(str + length, 'M', move, 2, false, false, false);
+	length += test_sequence(str + length, 'L', line, 4, true, true, true);
+	length += test_sequence(str + length, 'C', close, 2, false, true, true);
+
+	print_job_t *whole = test_parse((const char *)str, length, length);
+	print_job_t *split = test_parse((const char *)str, length, 3);
+	if (CHECK(whole != NULL && split != NULL)) {
+		vector_list_t *vector_list = whole->configs->vector_list;
+		CHECK(vector_list->length == 4);
+
+		vector_t vector;
+		vector_list_get(vector_list, 0, &vector);
+		CHECK(vector.start.x == 10 && vector.start.y == 20 && vector.end.x == 30 && vector.end.y == -40);
+		vector_list_get(vector_list, 2, &vector);
+		CHECK(vector.start.x == 50 && vector.start.y == 60 && vector.end.x == -70 && vector.end.y == 80);
+		vector_list_get(vector_list, 3, &vector);
+		CHECK(vector.end.x == 10 && vector.end.y == 20);
+
+		CHECK(test_same_vectors(vector_list, split->configs->vector_list));
+	}
+
+	print_job_destroy(whole);
+	print_job_destroy(split);
+}
+
+/*
+ * Distance from a point to the nearest vector of a list.
+ */
+static double test_deviation(vector_list_t *vector_list, double x, double y)
+{
+	double nearest = -1;
+	for (size_t index = 0; index < vector_list->length; index++) {
+		vector_t vector;
+		vector_list_get(vector_list, index, &vector);
+		double ax = vector.start.x, ay = vector.start.y;
+		double dx = vector.end.x - ax, dy = vector.end.y - ay;
+		double length = dx * dx + dy * dy;
+		double t = (length > 0) ? ((x - ax) * dx + (y - ay) * dy) / length : 0;
+		t = (t < 0) ? 0 : (t > 1) ? 1 : t;
+		double distance = hypot(x - (ax + t * dx), y - (ay + t * dy));
+		nearest = (nearest < 0 || distance < nearest) ? distance : nearest;
+	}
+	return nearest;
+}
+
+/*
+ * Curves are flattened into connected lines which stay within the flatness
+ * of the curve, allowing for points being rounded to whole units, and a
+ * curve which is already straight into a single line.
+ */
+static void test_curve_flatness(void)
+{
+	const char *str = "P0,0,255\nM0,0\nB0,1000,1000,1000,1000,0\nM0,2000\nB100,2000,200,2000,300,2000\n";
+
+	print_job_t *print_job = test_parse(str, strlen(str), strlen(str));
+	if (!CHECK(print_job != NULL))
+		return;
+
+	vector_list_t *vector_list = print_job->configs->vector_list;
+	double flatness = kinematics_flatness(print_job->kinematics, print_job->raster->resolution);
+
+	size_t lines = vector_list->length - 1;
+	CHECK(lines > 4 && lines <= VECTOR_PARSER_CURVE_STEPS);
+
+	bool connected = true;
+	for (size_t index = 1; index < lines; index++) {
+		vector_t vector, previous;
+		vector_list_get(vector_list, index - 1, &previous);
+		vector_list_get(vector_list, index, &vector);
+		connected = connected && point_equal(&previous.end, &vector.start);
+	}
+	CHECK(connected);
+
+	vector_t vector;
+	vector_list_get(vector_list, lines - 1, &vector);
+	CHECK(vector.end.x == 1000 && vector.end.y == 0);
+	vector_list_get(vector_list, lines, &vector);
+	CHECK(vector.start.x == 0 && vector.start.y == 2000 && vector.end.x == 300 && vector.end.y == 2000);
+
+	bool within = true;
+	for (int32_t step = 0; step <= 1000; step++) {
+		double t = step / 1000.0, u = 1 - t;
+		double x = 3 * u * t * t * 1000 + t * t * t * 1000;
+		double y = 3 * u * u * t * 1000 + 3 * u * t * t * 1000;
+		within = within && test_deviation(vector_list, x, y) <= flatness + 1;
+	}
+	CHECK(within);
+
+	print_job_destroy(print_job);
+}
+
+int main(void)
+{
+	test_text_chunks();
+	test_binary_sequences();
+	test_curve_flatness();
+
+	return test_result();
+}
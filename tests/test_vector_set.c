@@ -0,0 +1,69 @@
+#include <stdbool.h>          // for bool, false, true
+#include <stddef.h>           // for size_t
+#include <stdint.h>           // for int32_t, uint32_t
+#include "type_vector.h"      // for vector_t, vector_equal, vector_flip
+#include "type_vector_set.h"  // for vector_set_t, vector_set_contains, vector_set_create, vector_set_destroy, vector_set_insert, VECTOR_SET_INITIAL_CAPACITY
+#include "test.h"             // for CHECK, test_result
+
+// Vectors inserted, enough to grow the set several times
+#define TEST_VECTORS (4 * VECTOR_SET_INITIAL_CAPACITY)
+
+/*
+ * A vector from a small grid, so that repeats, in either direction, are
+ * common.
+ */
+static vector_t test_vector(uint32_t *seed)
+{
+	int32_t coordinates[4];
+	for (size_t index = 0; index < 4; index++) {
+		*seed = *seed * 1103515245 + 12345;
+		coordinates[index] = (int32_t)((*seed >> 16) % 12) - 6;
+	}
+	vector_t vector = { { coordinates[0], coordinates[1] }, { coordinates[2], coordinates[3] } };
+	return vector;
+}
+
+/*
+ * Insertion reports a vector as new exactly when neither it nor its reverse
+ * has been inserted before.
+ */
+static void test_insert_unique(void)
+{
+	static vector_t seen[TEST_VECTORS];
+	size_t seen_length = 0;
+
+	vector_set_t *vector_set = vector_set_create();
+	if (!CHECK(vector_set != NULL))
+		return;
+
+	uint32_t seed = 1;
+	bool agrees = true;
+	for (size_t count = 0; count < TEST_VECTORS; count++) {
+		vector_t vector = test_vector(&seed);
+		vector_t reverse = vector;
+		vector_flip(&reverse);
+
+		bool known = false;
+		for (size_t index = 0; index < seen_length && !known; index++)
+			known = vector_equal(&seen[index], &vector) || vector_equal(&seen[index], &reverse);
+		if (!known)
+			seen[seen_length++] = vector;
+
+		agrees = agrees && vector_set_insert(vector_set, &vector) == (known ? 0 : 1);
+		agrees = agrees && vector_set_contains(vector_set, &reverse);
+	}
+	CHECK(agrees);
+	CHECK(vector_set->length == seen_length);
+
+	vector_t absent = { { 100, 100 }, { 101, 101 } };
+	CHECK(!vector_set_contains(vector_set, &absent));
+
+	vector_set_destroy(vector_set);
+}
+
+int main(void)
+{
+	test_insert_unique();
+
+	return test_result();
+}